@@ -69,17 +69,10 @@ defigueiredo \
 	-p -i \
 	> defigueiredo.log 2>&1
 
-printf "$model_name: transforming compressed MCS to binary representation...\n\n"
-mcs2binary.py \
-	${model_name}.mcs.comp \
-	${model_name}.rfile_comp \
-	${model_name}.mcs.comp.binary 
-
 printf "$model_name: calculate PoF up to d=$d0 (STDOUT + STDERR in 'PoF.log')\n\n"
-count_compr_rxns.py ${model_name}.rfile_comp ${model_name}.num_comp_rxns
 PoFcalc \
-	-m ${model_name}.mcs.comp.binary \
-	-c ${model_name}.num_comp_rxns \
+	-m ${model_name}.mcs.comp \
+	-f ${model_name}.rfile_comp \
 	-r $(awk '{print NF}' ${model_name}.rfile) \
 	-d $d0 \
 	-t $t \
@@ -0,0 +1,48 @@
+#!/usr/bin/env python
+"""
+Client for the server mode of PoFcalc (-S). Sends one request per line
+(JSON objects) to a server listening on a Unix socket and prints the
+responses, e.g.
+
+	PoFcalc -m net.mcs -c net.num_comp_rxns -S /tmp/pofcalc.sock &
+	echo '{"cmd": "pof", "p": 1e-4, "d0": 4}' | pofcalc_client.py /tmp/pofcalc.sock
+
+Requests can also be given as arguments:
+
+	pofcalc_client.py /tmp/pofcalc.sock '{"cmd": "info"}' '{"cmd": "shutdown"}'
+"""
+import json
+import socket
+import sys
+
+
+class PoFcalcClient:
+	def __init__(self, path):
+		self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+		self.sock.connect(path)
+		self.reader = self.sock.makefile('r')
+
+	def request(self, **kwargs):
+		"""send a request and return the parsed response"""
+		return json.loads(self.send(json.dumps(kwargs)))
+
+	def send(self, line):
+		"""send a request given as JSON text and return the response line"""
+		self.sock.sendall((line.strip() + '\n').encode())
+		return self.reader.readline().rstrip('\n')
+
+	def close(self):
+		self.reader.close()
+		self.sock.close()
+
+
+if __name__ == '__main__':
+	if len(sys.argv) < 2:
+		print(__doc__)
+		sys.exit(1)
+	client = PoFcalcClient(sys.argv[1])
+	requests = sys.argv[2:] if len(sys.argv) > 2 else sys.stdin
+	for line in requests:
+		if line.strip():
+			print(client.send(line))
+	client.close()
@@ -0,0 +1,85 @@
+#!/bin/bash
+# regression tests of PoFcalc on the small networks in test_files
+# (run from the top directory after building: make test)
+
+pofcalc=./PoFcalc
+tf=test_files
+failed=0
+
+# check NAME EXPECTED CMD...: the output of CMD has to equal EXPECTED
+check() {
+	name=$1
+	expected=$2
+	shift 2
+	output=$("$@" 2>&1)
+	if [ "$output" == "$expected" ]
+	then
+		echo "ok    $name"
+	else
+		echo "FAIL  $name"
+		echo "  expected: $(echo $expected)"
+		echo "  got:      $(echo $output)"
+		failed=$((failed + 1))
+	fi
+}
+
+# value LABEL CMD...: the number after '= ' of the first output line
+# starting with LABEL (rounded to 12 significant digits)
+value() {
+	label=$1
+	shift
+	"$@" 2>&1 | grep -m 1 "^$label" | \
+		awk -F '= ' '{ split($2, a, " "); printf "%.11e\n", a[1] }'
+}
+
+# MCS file with only essential (d=1) columns 2, 5 and 7 (not sorted)
+check "all MCS1: lethality of deletion sets (-w)" "$(printf '1\n1\n0\n0\n1\n0')" \
+	bash -c "$pofcalc -m $tf/all_mcs1.binary -c $tf/all_mcs1.num_comp_rxns \
+		-w $tf/all_mcs1.queries | tail -n 6"
+# 1 - prod of (1 - p) over the rxns of the essential columns (brute force)
+check "all MCS1: PoF for rxn probabilities (-P)" "9.66738362500e-01" \
+	value "PoF for the rxn probabilities" $pofcalc -m $tf/all_mcs1.binary \
+	-c $tf/all_mcs1.num_comp_rxns -P $tf/all_mcs1.rxn_probs
+# the essential columns share their genes: 1 - q^3 for the 3 genes
+check "all MCS1: gene-level PoF (-G)" "2.99970001000e-04" \
+	value "Iterative PoF" $pofcalc -m $tf/all_mcs1.binary \
+	-G $tf/all_mcs1.genes
+
+# serve CMD...: start CMD (with -S on a fresh socket), wait for the socket
+# and run test_pofcalc_client.py against it (last lines of its output)
+serve() {
+	sock=$(mktemp -u /tmp/pofcalc_test.XXXXXX)
+	"$@" -S $sock > /dev/null 2>&1 &
+	server=$!
+	for i in $(seq 100)
+	do
+		[ -S $sock ] && break
+		sleep 0.1
+	done
+	${PYTHON:-python3} scripts/test_pofcalc_client.py $sock \
+		$tf/all_mcs1.binary 2>&1 | tail -n 5
+	# the server is still running if the client failed before the shutdown
+	kill $server 2> /dev/null
+	wait $server
+	rm -f $sock
+}
+check "server: round trip of pofcalc_client.py" \
+	"$(printf 'True\n[1, 0, 0]\nTrue\n2.99970001000e-04\nTrue')" \
+	serve $pofcalc -m $tf/all_mcs1.binary -c $tf/all_mcs1.num_comp_rxns
+# invalid files are reported and the server keeps running
+check "server: load of an empty MCS file" \
+	"$(printf '%s\n%s' \
+		'{"ok": false, "error": "no MCSs in /dev/null"}' \
+		'{"ok": true}')" \
+	bash -c "printf '%s\n%s\n' \
+		'{\"cmd\": \"load\", \"family\": \"e\", \"mcs\": \"/dev/null\"}' \
+		'{\"cmd\": \"shutdown\"}' | \
+		$pofcalc -m $tf/all_mcs1.binary -S - 2> /dev/null | \
+		sed 's/, \"seconds\": [^}]*//'"
+
+if [ $failed -gt 0 ]
+then
+	echo "$failed test(s) failed"
+	exit 1
+fi
+echo "all tests passed"
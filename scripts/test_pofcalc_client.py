@@ -0,0 +1,26 @@
+#!/usr/bin/env python
+"""
+Round trip between pofcalc_client.py and the server mode of PoFcalc (called
+by run_tests.sh): the requests are encoded by json.dumps (i.e. with spaces
+after ',' and ':'). Prints one line per request, e.g.
+
+	PoFcalc -m test_files/all_mcs1.binary -S /tmp/pofcalc.sock &
+	test_pofcalc_client.py /tmp/pofcalc.sock test_files/all_mcs1.binary
+"""
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from pofcalc_client import PoFcalcClient
+
+
+if __name__ == '__main__':
+	client = PoFcalcClient(sys.argv[1])
+	print(client.request(cmd='info')['ok'])
+	print(client.request(cmd='lethal', sets=['0010000000', '1000000000',
+	                                         '1000000001'])['lethal'])
+	print(client.request(cmd='load', family='copy', mcs=sys.argv[2])['ok'])
+	print('%.11e' % client.request(cmd='pof', family='copy', p=1e-4,
+	                               d0=2)['lower'])
+	print(client.request(cmd='shutdown')['ok'])
+	client.close()
@@ -1,20 +1,42 @@
 #ifndef POF_CALCULATOR_HPP
 #define POF_CALCULATOR_HPP
 
+#include "accumulator.hpp"
+#include "arena.hpp"
 #include "cutset.hpp"
+#include "exhaustive.hpp"
+#include "mcs_index.hpp"
+#include "oracle.hpp"
+#include "sampling.hpp"
 #include "table.hpp"
 #include "types.hpp"
+#include "zdd.hpp"
 // Luigi Pertoldi's progress bar from https://github.com/gipert/progressbar
 #include "../include/progressbar/progressbar.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <mutex>
+#include <omp.h>
+#include <parallel/algorithm>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
 using namespace std;
 
 const double WEIGHT_LIMIT = 1e-20;
+// quantile of the normal distribution for the 95% confidence intervals of the
+// Monte Carlo estimates
+const double CI_Z = 1.959963984540054;
+// marks rxns that are not part of any pair in the recursion
+const size_t NO_PAIR = numeric_limits<size_t>::max();
 // const double WEIGHT_LIMIT = numeric_limits<double>::min();
 
 /*
@@ -26,6 +48,10 @@ class PoF_calculator {
     bool m_compressed = false;
     // numb. of compr. rxns on each position if in compressed case
     vector<unsigned int> m_compr_rxn_counts;
+    // numb. of compr. rxns and names of all columns of the MCS file (i.e.
+    // before the reduction, names only if read from a file)
+    vector<unsigned int> m_column_rxn_counts;
+    vector<string> m_column_names;
     // positions of essential reactions
     vector<rxn_idx> m_mcs1_rxns;
     // numb. of rxns and MCSs for original MCS matrix and reduced form.
@@ -37,9 +63,69 @@ class PoF_calculator {
     // cut sets
     vector<Cutset> m_MCSs;
     // result table
-    Matrix<long> m_cd_table;
+    Matrix<wide_count> m_cd_table;
     // d0
     unsigned int m_max_d;
+    // numb. of lethal deletion sets of the reduced network per cardinality
+    // (only filled by the ZDD engine)
+    vector<long double> m_lethal_counts;
+    // numb. of uncompressed rxns in the columns used by the ZDD engine
+    size_t m_zdd_num_rxns = 0;
+    // anytime mode of the recursion: time limit and interval of the reports
+    // in seconds (0 --> disabled) and p and dm for the bounds in the reports
+    double m_time_limit = 0, m_report_interval = 0, m_report_p = 1e-4;
+    unsigned int m_report_dm = 0;
+    // top-level MCSs whose subtrees were not finished before the time limit
+    // as (Mj, a) --> count (see get_unfinished_table)
+    Counter m_unfinished;
+    // max. inclusion-exclusion order of the recursion (0 --> unlimited), the
+    // contributions of the recursion calls at that order and the result
+    // table of the Bonferroni upper bound (see split_bonferroni_tables)
+    unsigned int m_max_order = 0;
+    Matrix<wide_count> m_top_order_table, m_cd_table_upper;
+    // Monte Carlo estimate (see run_sampling): number of samples per number
+    // of deletions in the columns of the MCSs, the number of uncompressed
+    // rxns in these columns when sampling (-o drops columns later), the seed
+    // and the number of lethal samples for every such number
+    size_t m_num_samples = 0, m_sampled_rxns = 0;
+    uint64_t m_seed = 0;
+    vector<size_t> m_lethal_samples;
+    // attribution of the PoF to the MCSs (see set_attribution): number of
+    // MCSs and rxns to report (0 --> disabled), p, the probability of every
+    // MCS being the first one hit (by index in m_MCSs) and p^Mj and
+    // (1 - p)^a for the events in the result table. for the derivatives:
+    // probability of every reduced column being hit, derivative of the PoF
+    // by it and the sum of the probabilities of the events
+    size_t m_num_attributions = 0;
+    double m_attribution_p = 0;
+    vector<long double> m_mcs_contributions, m_pow_p, m_pow_q;
+    vector<long double> m_attribution_hit, m_col_derivatives;
+    long double m_event_sum = 0;
+    // heterogeneous failure probabilities (see set_rxn_probs): probability
+    // of every reduced column being hit, probability of no essential rxn
+    // being deleted and the sum of the probabilities of the events of the
+    // recursion
+    bool m_heterogeneous = false;
+    vector<long double> m_hit_probs;
+    long double m_survival_mcs1 = 1, m_hetero_sum = 0;
+    // gene-level failure model (see set_genes): genes of every reduced
+    // column, number of essential columns containing every gene and max.
+    // number of reduced columns sharing a gene
+    bool m_gene_level = false;
+    Matrix<unsigned int> m_col_genes;
+    vector<unsigned int> m_essential_gene_refs;
+    unsigned int m_max_gene_cols = 1;
+    // results for every prefix of the MCSs up to a cardinality (see
+    // set_prefixes): result table and number of MCSs per cardinality
+    // (running sums once the recursion is done)
+    bool m_prefixes = false;
+    vector<Matrix<wide_count>> m_prefix_tables;
+    vector<size_t> m_prefix_num_MCSs;
+    // stream for the log of the computation (the results are printed to
+    // stdout) and whether an overflowing count stops the program or is only
+    // recorded in m_count_overflow (see check_count_overflow)
+    ostream* m_log = &cout;
+    bool m_exit_on_overflow = true, m_count_overflow = false;
 
     // default constructor
     PoF_calculator() {
@@ -50,8 +136,19 @@ class PoF_calculator {
      * uncomprressed case (constructor delegation is new in C++11)
      */
     PoF_calculator(const string& mcs_input_fname, const string& comp_rxn_fname,
-                   size_t r = 0)
-        : PoF_calculator(mcs_input_fname) { // delegate to other constructor
+                   size_t r = 0, bool normalize = false)
+        : PoF_calculator(mcs_input_fname,
+                         normalize) { // delegate to other constructor
+        set_compression(comp_rxn_fname, r);
+        reduce_compr_rxn_counts();
+    }
+
+    /*
+     * read the file with the numbers of compressed rxns and set the number of
+     * uncompressed rxns. does not depend on the MCSs and can therefore also be
+     * used before streaming the MCS file.
+     */
+    void set_compression(const string& comp_rxn_fname, size_t r = 0) {
         read_comp_rxn_file(comp_rxn_fname);
         m_compressed = true;
         // if the numb. of uncompr. rxns has not been provided, r is the sum of
@@ -64,6 +161,242 @@ class PoF_calculator {
         } else {
             m_r = r;
         }
+    }
+
+    /*
+     * run the recursion in anytime mode: stop after time_limit seconds
+     * and/or print bounds of the PoF (for p and dm) every report_interval
+     * seconds. the bounds only use the top-level subtrees finished so far.
+     */
+    void set_anytime(double time_limit, double report_interval, double p,
+                     unsigned int dm) {
+        m_time_limit = time_limit;
+        m_report_interval = report_interval;
+        m_report_p = p;
+        m_report_dm = dm;
+    }
+
+    /*
+     * attribute the PoF (for p) to the MCSs and rxns during the recursion and
+     * report the num_attributions largest contributions in print_results.
+     * the top-level subtree of an MCS counts the event "MCS hit and no
+     * earlier MCS hit" --> the probabilities of these events partition the
+     * PoF and are accumulated per subtree (see print_attribution). the
+     * derivative of the PoF by the failure probability of every rxn is
+     * summed up over the events of the recursion (see add_event_derivatives).
+     */
+    void set_attribution(double p, size_t num_attributions) {
+        m_attribution_p = p;
+        m_num_attributions = num_attributions;
+    }
+
+    /*
+     * read a failure probability for every rxn (whitespace-separated) and let
+     * the recursion sum up the exact probabilities of its events: "the rxns
+     * in Cs deleted and the plus 1 rxns not deleted" has the probability
+     * prod_Cs h_c * prod_plus1 (1 - h_c) (times the pair correction), h_c
+     * being the probability that at least one rxn of column c is deleted.
+     * the file holds either one probability per uncompressed rxn (the rxns
+     * of every column numbered consecutively; rxns beyond the columns are
+     * ignored) or one per column (used for all of its rxns).
+     */
+    void set_rxn_probs(const string& fname) {
+        vector<long double> probs;
+        ifstream file(fname);
+        if (!file.is_open()) {
+            cout << "Error opening rxn probabilities file" << endl;
+            exit(EXIT_FAILURE);
+        }
+        long double prob;
+        while (file >> prob) {
+            if ((prob < 0) || (prob >= 1)) {
+                cout << "Error: rxn probabilities should be between 0 and 1"
+                     << endl;
+                exit(EXIT_FAILURE);
+            }
+            probs.push_back(prob);
+        }
+        file.close();
+        size_t num_cols = m_r_reduced + m_mcs1_rxns.size(), num_rxns = 0;
+        for (size_t col = 0; col < num_cols; col++) {
+            num_rxns += (m_column_rxn_counts.size() > 0)
+                            ? m_column_rxn_counts[col]
+                            : 1;
+        }
+        bool per_column = (probs.size() == num_cols);
+        if (!per_column && (probs.size() != num_rxns) &&
+            (probs.size() != m_r)) {
+            cout << "Error: expected " << num_cols;
+            if (num_rxns != num_cols) {
+                cout << " (one per column) or " << num_rxns;
+            }
+            if (m_r != num_rxns) {
+                cout << " or " << m_r;
+            }
+            cout << " rxn probabilities but found " << probs.size() << endl;
+            exit(EXIT_FAILURE);
+        }
+        m_heterogeneous = true;
+        m_hit_probs.clear();
+        m_survival_mcs1 = 1;
+        size_t rxn = 0, e = 0;
+        for (size_t col = 0; col < num_cols; col++) {
+            unsigned int n = (m_column_rxn_counts.size() > 0)
+                                 ? m_column_rxn_counts[col]
+                                 : 1;
+            long double survival = 1;
+            for (unsigned int i = 0; i < n; i++, rxn++) {
+                survival *= 1 - probs[(per_column) ? col : rxn];
+            }
+            if ((e < m_mcs1_rxns.size()) && (m_mcs1_rxns[e] == col)) {
+                m_survival_mcs1 *= survival;
+                e++;
+            } else {
+                m_hit_probs.push_back(1 - survival);
+            }
+        }
+    }
+
+    /*
+     * read the genes of every column (one line per column of the MCS file,
+     * e.g. the GPR rule of a complex: gene names separated by whitespace,
+     * commas, parentheses or 'and') and calculate the PoF for the deletion of
+     * genes instead of rxns: a column is hit if any of its genes is deleted.
+     * columns can share genes --> the events of the recursion are resolved
+     * by resolve_gene_level_cutset instead of resolve_compressed_cutset and
+     * the plus 1 rxns count the distinct genes of the plus 1 (and essential)
+     * columns. isozymes ('or') can't be expressed this way.
+     */
+    void set_genes(const string& fname) {
+        ifstream file(fname);
+        if (!file.is_open()) {
+            cout << "Error opening genes file" << endl;
+            exit(EXIT_FAILURE);
+        }
+        unordered_map<string, unsigned int> gene_ids;
+        Matrix<unsigned int> genes;
+        string line, name;
+        while (getline(file, line)) {
+            genes.push_back(vector<unsigned int>());
+            istringstream tokens(line);
+            while (tokens >> name) {
+                for (char& c : name) {
+                    if ((c == ',') || (c == '(') || (c == ')')) {
+                        c = ' ';
+                    }
+                }
+                istringstream parts(name);
+                string part;
+                while (parts >> part) {
+                    if ((part == "and") || (part == "AND")) {
+                        continue;
+                    }
+                    if ((part == "or") || (part == "OR")) {
+                        cout << "Error: isozymes ('or') are not supported in "
+                                "the genes file"
+                             << endl;
+                        exit(EXIT_FAILURE);
+                    }
+                    auto search = gene_ids.find(part);
+                    if (search == gene_ids.end()) {
+                        search = gene_ids.insert(make_pair(part,
+                                                           gene_ids.size()))
+                                     .first;
+                    }
+                    genes.back().push_back(search->second);
+                }
+            }
+            sort(genes.back().begin(), genes.back().end());
+            genes.back().erase(unique(genes.back().begin(), genes.back().end()),
+                               genes.back().end());
+        }
+        file.close();
+        size_t num_cols = m_r_reduced + m_mcs1_rxns.size();
+        while ((genes.size() > num_cols) && (genes.back().size() == 0)) {
+            genes.pop_back();
+        }
+        if (genes.size() != num_cols) {
+            cout << "Error: expected the genes of " << num_cols
+                 << " columns but found " << genes.size() << " lines" << endl;
+            exit(EXIT_FAILURE);
+        }
+        m_gene_level = true;
+        m_compressed = true;
+        m_r = gene_ids.size();
+        m_essential_gene_refs.assign(m_r, 0);
+        m_num_mcs1_uncompressed = 0;
+        m_col_genes.clear();
+        m_compr_rxn_counts.clear();
+        vector<unsigned int> num_gene_cols(m_r, 0);
+        size_t e = 0;
+        for (size_t col = 0; col < num_cols; col++) {
+            if ((e < m_mcs1_rxns.size()) && (m_mcs1_rxns[e] == col)) {
+                for (unsigned int gene : genes[col]) {
+                    m_num_mcs1_uncompressed +=
+                        (m_essential_gene_refs[gene]++ == 0);
+                }
+                e++;
+            } else {
+                for (unsigned int gene : genes[col]) {
+                    num_gene_cols[gene]++;
+                }
+                m_col_genes.push_back(genes[col]);
+                m_compr_rxn_counts.push_back(genes[col].size());
+            }
+        }
+        m_max_gene_cols = 1;
+        for (unsigned int n : num_gene_cols) {
+            m_max_gene_cols = max(m_max_gene_cols, n);
+        }
+        *m_log << "Read " << m_r << " genes of " << num_cols << " columns ("
+             << m_num_mcs1_uncompressed << " essential genes, up to "
+             << m_max_gene_cols << " columns per gene)\n"
+             << endl;
+    }
+
+    /*
+     * additionally report the PoF for every prefix of the MCSs up to
+     * cardinality dm' (as if the MCS file only held them). the MCSs are
+     * sorted by cardinality and the top-level subtree of an MCS only uses
+     * earlier MCSs --> the results of the subtrees are collected per
+     * cardinality of their MCS and summed up (see start_recursion and
+     * finish_prefix_tables) instead of running the recursion per prefix.
+     */
+    void set_prefixes() {
+        m_prefixes = true;
+    }
+
+    /*
+     * write the log of the computation (e.g. progress messages) to log
+     * instead of cout. the progress bar is only shown on cout.
+     */
+    void set_log(ostream& log) {
+        m_log = &log;
+    }
+
+    /*
+     * let an overflowing count stop the program (default) or only set
+     * m_count_overflow (checked after get_cardinalities)
+     */
+    void set_exit_on_overflow(bool exit_program) {
+        m_exit_on_overflow = exit_program;
+    }
+
+    /*
+     * truncate the inclusion-exclusion of the recursion after max_order MCSs
+     * (i.e. don't recurse deeper than depth max_order). yields lower and upper
+     * (Bonferroni) bounds of F(d) from the orders max_order - 1 and max_order.
+     */
+    void set_max_order(unsigned int max_order) {
+        m_max_order = max_order;
+    }
+
+    /*
+     * remove the essential rxns from the vector of compressed rxns. requires
+     * m_mcs1_rxns to be known already.
+     */
+    void reduce_compr_rxn_counts() {
+        m_column_rxn_counts = m_compr_rxn_counts;
         // find the number of uncompressed mcs1 rxns
         for (size_t rxn_id : m_mcs1_rxns) {
             m_num_mcs1_uncompressed += m_compr_rxn_counts[rxn_id];
@@ -80,10 +413,82 @@ class PoF_calculator {
     }
 
     /*
-     * constructor for uncompressed case
+     * constructor for uncompressed case. if normalize is set, the MCSs are
+     * sorted, deduplicated and filtered for minimality first.
+     */
+    PoF_calculator(const string& mcs_input_fname, bool normalize = false) {
+        set_MCSs(read_MCS_file(mcs_input_fname), normalize);
+    }
+
+    /*
+     * constructor for MCS files with lists of reaction names (e.g. the output
+     * of defigueiredo) instead of binary strings. the names are mapped to
+     * their positions in rxn_names (e.g. read from an rfile or rfile_comp via
+     * read_rxn_name_file()). if the names are those of a compressed network
+     * (i.e. contain uncompressed names joined by '%'), the numbers of
+     * compressed rxns are derived from them.
+     */
+    PoF_calculator(const string& mcs_input_fname,
+                   const vector<string>& rxn_names, size_t r = 0,
+                   bool normalize = false) {
+        set_MCSs(read_MCS_name_file(mcs_input_fname, rxn_names), normalize);
+        m_column_names = rxn_names;
+        vector<unsigned int> compr_rxn_counts;
+        compr_rxn_counts.reserve(rxn_names.size());
+        bool compressed = false;
+        for (const string& name : rxn_names) {
+            compr_rxn_counts.push_back(count(name.begin(), name.end(), '%') +
+                                       1);
+            compressed |= compr_rxn_counts.back() > 1;
+        }
+        if (compressed) {
+            m_compr_rxn_counts = compr_rxn_counts;
+            m_compressed = true;
+            m_r = (r == 0) ? sum_vec(compr_rxn_counts) : r;
+            reduce_compr_rxn_counts();
+        }
+    }
+
+    /*
+     * constructor for MCSs that are already in memory (e.g. from the library
+     * API, see pofcalc.hpp). the MCSs are moved in and sorted by cardinality.
+     * the numbers of compressed rxns per column and the number of
+     * uncompressed rxns are used as in the constructor for compressed
+     * networks (no numbers --> uncompressed network). the log is written to
+     * log (see set_log).
+     */
+    PoF_calculator(vector<Cutset> MCSs,
+                   const vector<unsigned int>& compr_rxn_counts, size_t r = 0,
+                   bool normalize = false, ostream* log = &cout)
+        : m_log(log) {
+        if (!normalize) {
+            stable_sort(MCSs.begin(), MCSs.end(),
+                        [](const Cutset& a, const Cutset& b) {
+                            return a.CARDINALITY() < b.CARDINALITY();
+                        });
+        }
+        set_MCSs(move(MCSs), normalize);
+        if (compr_rxn_counts.size() > 0) {
+            m_compr_rxn_counts = compr_rxn_counts;
+            m_compressed = true;
+            m_r = (r == 0) ? sum_vec(compr_rxn_counts) : r;
+            reduce_compr_rxn_counts();
+        }
+    }
+
+    /*
+     * set the MCSs (sorted by cardinality unless normalize is set) and reduce
+     * them if essential rxns are present
      */
-    PoF_calculator(const string& mcs_input_fname) {
-        vector<Cutset> MCSs = read_MCS_file(mcs_input_fname);
+    void set_MCSs(vector<Cutset> MCSs, bool normalize = false) {
+        if (normalize) {
+            *m_log << "Normalizing MCSs...\n" << endl;
+            MCSs = normalize_MCS_arr(move(MCSs), m_log);
+        }
+        if (MCSs.size() == 0) {
+            cout << "Error: no MCSs given (empty MCS file?)" << endl;
+            exit(EXIT_FAILURE);
+        }
         m_r = MCSs[0].m_len;
         m_nMCS = MCSs.size();
         // set 'reduced' variables (are overwritten in reduce_MCS_arr() later)
@@ -92,10 +497,10 @@ class PoF_calculator {
         // only reduce matrix if MCS with d=1 are present
         if ((MCSs[0].CARDINALITY() == 1)) {
             m_MCS_d1_present = true;
-            cout << "Reducing MCS matrix...\n" << endl;
+            *m_log << "Reducing MCS matrix...\n" << endl;
             MCSs = reduce_MCS_arr(MCSs);
         }
-        m_MCSs = MCSs;
+        m_MCSs = move(MCSs);
     }
 
     /*
@@ -106,7 +511,7 @@ class PoF_calculator {
         string line;
         ifstream file(fname);
         if (file.is_open()) {
-            cout << "Reading comp. rxns file...\n" << endl;
+            *m_log << "Reading comp. rxns file...\n" << endl;
             getline(file, line);
             file.close();
         } else {
@@ -132,7 +537,7 @@ class PoF_calculator {
         vector<Cutset> MCSs;
         ifstream file(fname);
         if (file.is_open()) {
-            cout << "Reading MCS file...\n" << endl;
+            *m_log << "Reading MCS file...\n" << endl;
             while (getline(file, line)) {
                 Cutset cs(line); // instantiate Cutset object for every line
                 MCSs.push_back(cs);
@@ -145,6 +550,153 @@ class PoF_calculator {
         return MCSs;
     }
 
+    /*
+     * read file with whitespace-separated reaction names (e.g. an rfile or
+     * rfile_comp). quotes around the names are removed.
+     */
+    static vector<string> read_rxn_name_file(const string& fname) {
+        vector<string> rxn_names;
+        ifstream file(fname);
+        if (!file.is_open()) {
+            cout << "Error opening rxn names file" << endl;
+            exit(EXIT_FAILURE);
+        }
+        cout << "Reading rxn names file...\n" << endl;
+        string name;
+        while (file >> name) {
+            name.erase(remove(name.begin(), name.end(), '"'), name.end());
+            rxn_names.push_back(name);
+        }
+        file.close();
+        return rxn_names;
+    }
+
+    /*
+     * read file with MCSs given as lists of reaction names separated by
+     * spaces or commas. file should be sorted by MCS cardinality and look
+     * like:
+     * 'R_PGI R_TPI
+     *  R_ENO R_PYK R_PPS'
+     * the names are hashed into their indices in rxn_names.
+     */
+    vector<Cutset> read_MCS_name_file(const string& fname,
+                                      const vector<string>& rxn_names) {
+        unordered_map<string, rxn_idx> rxn_ids;
+        rxn_ids.reserve(rxn_names.size());
+        for (rxn_idx i = 0; i < rxn_names.size(); i++) {
+            rxn_ids[rxn_names[i]] = i;
+        }
+        string line, name;
+        vector<Cutset> MCSs;
+        ifstream file(fname);
+        if (file.is_open()) {
+            *m_log << "Reading MCS file...\n" << endl;
+            while (getline(file, line)) {
+                Cutset cs(rxn_names.size());
+                size_t pos = 0;
+                while (pos < line.size()) {
+                    size_t end = line.find_first_of(" ,\t\r", pos);
+                    if (end == string::npos) {
+                        end = line.size();
+                    }
+                    if (end > pos) {
+                        name.assign(line, pos, end - pos);
+                        auto search = rxn_ids.find(name);
+                        if (search == rxn_ids.end()) {
+                            cout << "Error: unknown reaction name '" << name
+                                 << "' in MCS file" << endl;
+                            exit(EXIT_FAILURE);
+                        }
+                        cs.m_active_rxns.push_back(search->second);
+                    }
+                    pos = end + 1;
+                }
+                if (cs.CARDINALITY() == 0) {
+                    continue; // skip empty lines
+                }
+                sort(cs.m_active_rxns.begin(), cs.m_active_rxns.end());
+                MCSs.push_back(cs);
+            }
+            file.close();
+        } else {
+            cout << "Error opening MCS file" << endl;
+            exit(EXIT_FAILURE);
+        }
+        return MCSs;
+    }
+
+    /*
+     * sort MCSs by cardinality (in parallel), remove duplicates and remove
+     * all cut sets that are supersets of other ones (i.e. not minimal). the
+     * superset check uses an inverted index over the already accepted MCSs of
+     * lower cardinality and is therefore roughly linear in the input size.
+     * the number of removed cut sets is written to log (nullptr --> silent).
+     */
+    static vector<Cutset> normalize_MCS_arr(vector<Cutset> MCSs,
+                                            ostream* log = &cout) {
+        size_t num_input = MCSs.size();
+        // empty lines don't represent cut sets
+        MCSs.erase(remove_if(MCSs.begin(), MCSs.end(),
+                             [](const Cutset& cs) {
+                                 return cs.CARDINALITY() == 0;
+                             }),
+                   MCSs.end());
+        // sort by cardinality first and lexicographically second -->
+        // duplicates end up next to each other
+        __gnu_parallel::sort(
+            MCSs.begin(), MCSs.end(), [](const Cutset& a, const Cutset& b) {
+                if (a.CARDINALITY() != b.CARDINALITY()) {
+                    return a.CARDINALITY() < b.CARDINALITY();
+                }
+                return a.m_active_rxns < b.m_active_rxns;
+            });
+        MCSs.erase(unique(MCSs.begin(), MCSs.end(),
+                          [](const Cutset& a, const Cutset& b) {
+                              return a.m_active_rxns == b.m_active_rxns;
+                          }),
+                   MCSs.end());
+        size_t num_duplicates = num_input - MCSs.size();
+        // filter non-minimal sets one cardinality at a time. sets of equal
+        // cardinality can't be subsets of each other --> every bucket can be
+        // checked in parallel against the index of all smaller MCSs.
+        size_t num_rxns = (MCSs.size() > 0) ? MCSs[0].m_len : 0;
+        MCS_index index(num_rxns);
+        vector<Cutset> minimal;
+        minimal.reserve(MCSs.size());
+        vector<char> is_minimal(MCSs.size());
+        size_t bucket_start = 0;
+        while (bucket_start < MCSs.size()) {
+            unsigned int card = MCSs[bucket_start].CARDINALITY();
+            size_t bucket_end = bucket_start;
+            while ((bucket_end < MCSs.size()) &&
+                   (MCSs[bucket_end].CARDINALITY() == card)) {
+                bucket_end++;
+            }
+#pragma omp parallel
+            {
+                MCS_index::query_buffer buf;
+#pragma omp for schedule(dynamic, 256)
+                for (size_t i = bucket_start; i < bucket_end; i++) {
+                    is_minimal[i] = (index.find_subset(MCSs[i], buf) < 0);
+                }
+            }
+            for (size_t i = bucket_start; i < bucket_end; i++) {
+                if (is_minimal[i]) {
+                    index.add(MCSs[i]);
+                    minimal.push_back(move(MCSs[i]));
+                }
+            }
+            bucket_start = bucket_end;
+        }
+        if (log) {
+            *log << "removed " << num_duplicates << " duplicate and "
+                 << num_input - num_duplicates - minimal.size()
+                 << " non-minimal cut sets\n"
+                 << endl;
+        }
+        return minimal;
+    }
+
     /*
      * reduce MCS matrix by removing all essential reactions and the MCSs
      * containing those.
@@ -152,12 +704,15 @@ class PoF_calculator {
     vector<Cutset> reduce_MCS_arr(const vector<Cutset>& MCSs) {
         // find number of essential rxns and the corresponding indices
         if (MCSs.back().CARDINALITY() == 1) {
-            // matrix only has MCS with d=1 and is reduced to nothing
+            // matrix only has MCS with d=1 and is reduced to nothing (the
+            // other rxns remain as columns that aren't in any MCS)
             m_num_mcs1 = MCSs.size();
             for (const Cutset& cs : MCSs) {
                 m_mcs1_rxns.push_back(cs.get_first_active_rxn());
             }
-            m_r_reduced = 0;
+            // sort mcs1 rxns --> the columns are merged with them in order
+            sort(m_mcs1_rxns.begin(), m_mcs1_rxns.end());
+            m_r_reduced = m_r - m_num_mcs1;
             m_nMCS_reduced = 0;
             return vector<Cutset>();
 
@@ -189,192 +744,1983 @@ class PoF_calculator {
     }
 
     /*
-     * pre-populate result table based on number of essential reactions
+     * detect reactions that are interchangeable with respect to the MCSs and
+     * merge them into a single compressed column (as the external compression
+     * would do for linearly coupled reactions). two reactions x and y are
+     * interchangeable if replacing x by y in every MCS containing x yields
+     * exactly the MCSs containing y, i.e. {M \ {x} : x in M} equals
+     * {M \ {y} : y in M}. a column then stands for several reactions of which
+     * any single one has to be deleted --> the compressed code path handles
+     * them. note that reactions with identical incidence columns (i.e. always
+     * deleted together) can't be merged this way. candidates are found by
+     * hashing these sets and verified exactly afterwards.
+     */
+    void merge_equivalent_rxns() {
+        if (m_MCSs.size() == 0) {
+            return;
+        }
+        auto mix = [](uint64_t x) { // splitmix64 finalizer
+            x += 0x9e3779b97f4a7c15ULL;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        };
+        // MCSs containing each reaction
+        vector<vector<size_t>> rxn_MCSs(m_r_reduced);
+        vector<uint64_t> MCS_hashes(m_MCSs.size(), 0);
+        for (size_t i = 0; i < m_MCSs.size(); i++) {
+            for (rxn_idx rxn : m_MCSs[i].m_active_rxns) {
+                rxn_MCSs[rxn].push_back(i);
+                MCS_hashes[i] += mix(rxn);
+            }
+        }
+        // hash of {M \ {x} : x in M} for every reaction x (order independent)
+        map<pair<uint64_t, size_t>, vector<rxn_idx>> candidates;
+        for (rxn_idx rxn = 0; rxn < m_r_reduced; rxn++) {
+            if (rxn_MCSs[rxn].size() == 0) {
+                continue;
+            }
+            uint64_t hash = 0;
+            for (size_t i : rxn_MCSs[rxn]) {
+                hash += mix(MCS_hashes[i] - mix(rxn));
+            }
+            candidates[make_pair(hash, rxn_MCSs[rxn].size())].push_back(rxn);
+        }
+        // verify candidates and assign every reaction its new column
+        auto get_remainders = [&](rxn_idx rxn) {
+            vector<vector<rxn_idx>> remainders;
+            for (size_t i : rxn_MCSs[rxn]) {
+                vector<rxn_idx> rest;
+                for (rxn_idx other : m_MCSs[i].m_active_rxns) {
+                    if (other != rxn) {
+                        rest.push_back(other);
+                    }
+                }
+                remainders.push_back(rest);
+            }
+            sort(remainders.begin(), remainders.end());
+            return remainders;
+        };
+        vector<rxn_idx> representative(m_r_reduced);
+        for (rxn_idx rxn = 0; rxn < m_r_reduced; rxn++) {
+            representative[rxn] = rxn;
+        }
+        size_t num_merged = 0;
+        for (const auto& elem : candidates) {
+            vector<rxn_idx> group = elem.second;
+            while (group.size() > 1) {
+                vector<vector<rxn_idx>> ref = get_remainders(group[0]);
+                vector<rxn_idx> rest;
+                for (size_t k = 1; k < group.size(); k++) {
+                    if (get_remainders(group[k]) == ref) {
+                        representative[group[k]] = group[0];
+                        num_merged++;
+                    } else {
+                        rest.push_back(group[k]);
+                    }
+                }
+                group = rest;
+            }
+        }
+        *m_log << "Merged " << num_merged << " interchangeable reactions\n"
+             << endl;
+        if (num_merged == 0) {
+            return;
+        }
+        // new column indices and numbers of compressed rxns
+        vector<unsigned int> old_counts = m_compr_rxn_counts;
+        if (!m_compressed) {
+            old_counts = vector<unsigned int>(m_r_reduced, 1);
+            m_num_mcs1_uncompressed = m_num_mcs1;
+            m_compressed = true;
+        }
+        vector<rxn_idx> new_idx(m_r_reduced);
+        m_compr_rxn_counts.clear();
+        for (rxn_idx rxn = 0; rxn < m_r_reduced; rxn++) {
+            if (representative[rxn] == rxn) {
+                new_idx[rxn] = m_compr_rxn_counts.size();
+                m_compr_rxn_counts.push_back(old_counts[rxn]);
+            } else {
+                new_idx[rxn] = new_idx[representative[rxn]];
+                m_compr_rxn_counts[new_idx[rxn]] += old_counts[rxn];
+            }
+        }
+        m_r_reduced = m_compr_rxn_counts.size();
+        // map MCSs to the new columns and drop the resulting duplicates
+        // (keeping the order)
+        set<vector<rxn_idx>> seen;
+        vector<Cutset> merged;
+        merged.reserve(m_MCSs.size());
+        for (const Cutset& cs : m_MCSs) {
+            Cutset new_cs(m_r_reduced);
+            new_cs.m_active_rxns.reserve(cs.CARDINALITY());
+            for (rxn_idx rxn : cs.m_active_rxns) {
+                new_cs.m_active_rxns.push_back(new_idx[rxn]);
+            }
+            sort(new_cs.m_active_rxns.begin(), new_cs.m_active_rxns.end());
+            if (seen.insert(new_cs.m_active_rxns).second) {
+                merged.push_back(new_cs);
+            }
+        }
+        m_MCSs = merged;
+        m_nMCS_reduced = m_MCSs.size();
+        *m_log << m_r_reduced << " columns and " << m_nMCS_reduced
+             << " MCSs remaining\n"
+             << endl;
+    }
+
+    /*
+     * pre-populate result table based on number of essential reactions
+     */
+    void add_MCS1_to_table() {
+        unsigned int num_mcs1 =
+            (m_compressed) ? m_num_mcs1_uncompressed : m_num_mcs1;
+        size_t Mj = 1; // cardinality of MCS1 = 1
+        for (size_t a = 0; a < num_mcs1; a++) {
+            m_cd_table[Mj - 1][a]++;
+        }
+    }
+
+    /*
+     * pretty-print result table (e.g. for debugging)
+     */
+    void print_cd_table() const {
+        Table table({"|Mj|", "a", "#"}, {15, 15, 15}, {"%.5g", "%g", "%g"}
+                    // uses scientific fmt in case the numbers
+                    ); // get too large
+        table.print_header();
+        for (size_t Mj = 0; Mj < m_cd_table.size(); Mj++) {
+            for (size_t a = 0; a < m_cd_table[Mj].size(); a++) {
+                auto count = m_cd_table[Mj][a];
+                if (count != 0) {
+                    // actual Mj is larger by 1 (0-based indexing)
+                    table.print_row(
+                        vector<double>{Mj + 1, a, (double)count});
+                }
+            }
+        }
+    }
+
+    /*
+     * set d0 and initialize the result table. returns the (potentially
+     * corrected) d0.
+     */
+    unsigned int init_cd_table(unsigned int max_d) {
+        // check if d0 supplied at cmd line is greater than the number of rxns
+        if ((max_d > m_r) || (max_d == 0)) {
+            max_d = m_r;
+        }
+        m_max_d = max_d;
+        // initialize result table with rows for every 0 < d <= d0 and columns
+        // for every reaction (representing plus 1 rxns)
+        m_cd_table = Matrix<wide_count>(max_d, vector<wide_count>(m_r, 0));
+        return max_d;
+    }
+
+    /*
+     * main function preparing for and then invoking recursion
+     */
+    void get_cardinalities(unsigned int max_d, unsigned int num_threads = 1,
+                           bool use_cache = true, bool reorder = false,
+                           bool components = false,
+                           unsigned int exhaustive_max_cols = 26,
+                           const string& zdd_order = "") {
+        m_count_overflow = false;
+        max_d = init_cd_table(max_d);
+        // max. number of columns of the cut sets: k genes hit at most k
+        // times as many columns in the gene-level model
+        unsigned int max_cols = max_d;
+        if (m_gene_level) {
+            max_cols = min<size_t>(m_r_reduced, max_d * m_max_gene_cols);
+        }
+        size_t last_MCS_to_consider = m_MCSs.size();
+        if (m_MCS_d1_present) {
+            // add MCS1 to table
+            *m_log << "adding MCS(d=1) to table...\n" << endl;
+            add_MCS1_to_table();
+            if (m_MCSs.size() == 0) {
+                // MCS matrix was reduced to nothing --> only MCS with d=1 in
+                // original matrix
+                *m_log << "no MCS with d>1 present --> no recursion required\n"
+                     << endl;
+                return;
+            }
+        }
+        *m_log << "Starting recursion...\n" << endl;
+        // check if there are MCS with d > d0 (max_d)
+        if (m_MCSs.back().CARDINALITY() > max_cols) {
+            // get the last element with d <= max_d
+            for (size_t i = 0; i < m_MCSs.size(); i++) {
+                if (m_MCSs[i].CARDINALITY() > max_cols) {
+                    last_MCS_to_consider = i;
+                    break;
+                }
+            }
+        }
+        if (zdd_order.size() > 0) {
+            *m_log << "Building ZDD of the MCSs...\n" << endl;
+            run_zdd(last_MCS_to_consider, max_d, zdd_order);
+            return;
+        }
+        if (exhaustive_possible(exhaustive_max_cols) &&
+            (m_num_attributions == 0) && !m_heterogeneous && !m_gene_level &&
+            !m_prefixes) {
+            *m_log << "Enumerating all deletion sets of the " << m_r_reduced
+                 << " columns...\n"
+                 << endl;
+            // exact F(d) for all d --> extend the table to all cardinalities
+            m_max_d = m_r;
+            m_cd_table.resize(max(m_cd_table.size(), get_num_reduced_rxns()),
+                              vector<wide_count>(m_r, 0));
+            run_exhaustive(num_threads);
+            return;
+        }
+        if (reorder) {
+            *m_log << "Reordering reactions...\n" << endl;
+            reorder_for_locality(last_MCS_to_consider);
+        }
+        if (components) {
+            get_cardinalities_by_component(last_MCS_to_consider, max_d,
+                                           num_threads, use_cache,
+                                           exhaustive_max_cols);
+        } else if ((m_time_limit > 0) || (m_report_interval > 0)) {
+            run_recursion_anytime(last_MCS_to_consider, max_d, num_threads,
+                                  use_cache);
+        } else {
+            if (m_num_attributions > 0) {
+                init_attribution(max_d);
+            }
+            if (m_prefixes) {
+                init_prefix_tables(last_MCS_to_consider);
+            }
+            run_recursion(last_MCS_to_consider, max_cols, num_threads,
+                          use_cache);
+            if (m_prefixes) {
+                finish_prefix_tables();
+            }
+            if (m_max_order > 0) {
+                split_bonferroni_tables();
+            }
+        }
+    }
+
+    /*
+     * per-thread state of the recursion. the temporaries of every call live
+     * in the arena. the plus 1 rxns and the pairs (see GET_CARDINALITIES) are
+     * shared by all calls on the stack: a call adds to them and undoes its
+     * changes before returning instead of working on its own copy.
+     */
+    struct recursion_state {
+        struct marker {
+            Arena::marker arena;
+            size_t num_stored, num_pair_log;
+        };
+        // entry of the undo log for the pairs
+        struct pair_op {
+            size_t pair;
+            bool added; // added or dropped
+        };
+
+        Arena arena;
+        // plus 1 rxns in the order they were added and a flag for every rxn
+        vector<rxn_idx> stored;
+        vector<char> is_stored;
+        // all pairs added by the calls on the stack, whether they are still
+        // active and the active pair of every rxn (or NO_PAIR)
+        vector<rxn_pair> pairs;
+        vector<char> pair_active;
+        vector<size_t> pair_of;
+        vector<pair_op> pair_log;
+        // results of the thread (added to m_cd_table at the end) and the part
+        // of them added at the max. inclusion-exclusion order
+        Accumulator counts, top_order_counts;
+        // set to abort the recursion (anytime mode)
+        const atomic<bool>* stop = nullptr;
+        // probability of the events counted in the current top-level subtree
+        // (attribution), derivatives of the PoF by the probabilities of the
+        // columns being hit (empty --> disabled) and the sum of the
+        // probabilities of the events
+        long double contribution = 0;
+        vector<long double> col_derivatives;
+        long double event_sum = 0;
+        // heterogeneous probabilities: probabilities of the columns being hit
+        // (nullptr --> disabled), products of (1 - h) over the first i + 1
+        // plus 1 rxns and the sum of the probabilities of the events
+        const vector<long double>* hit_probs = nullptr;
+        vector<long double> stored_survival;
+        long double hetero_sum = 0;
+        // gene-level model: genes of the columns (nullptr --> disabled), the
+        // number of plus 1 and essential columns containing every gene and
+        // the number of genes contained in any of them
+        const Matrix<unsigned int>* col_genes = nullptr;
+        vector<unsigned int> gene_refs;
+        size_t num_blocked_genes = 0;
+
+        recursion_state(size_t num_rxns, const Accumulator& counts)
+            : is_stored(num_rxns, 0), pair_of(num_rxns, NO_PAIR),
+              counts(counts) {
+        }
+
+        marker mark() const {
+            return marker{arena.mark(), stored.size(), pair_log.size()};
+        }
+
+        /*
+         * bytes held by the state (without the small per-call vectors)
+         */
+        size_t get_memory() const {
+            return arena.get_memory() + counts.get_memory() +
+                   top_order_counts.get_memory() + is_stored.size() +
+                   col_derivatives.size() * sizeof(long double) +
+                   pair_of.size() * sizeof(size_t) +
+                   gene_refs.size() * sizeof(unsigned int);
+        }
+
+        /*
+         * undo everything that happened since the marker was taken
+         */
+        void rewind(const marker& m) {
+            arena.release(m.arena);
+            while (stored.size() > m.num_stored) {
+                is_stored[stored.back()] = 0;
+                if (col_genes) {
+                    for (unsigned int gene : (*col_genes)[stored.back()]) {
+                        num_blocked_genes -= (--gene_refs[gene] == 0);
+                    }
+                }
+                stored.pop_back();
+                if (hit_probs) {
+                    stored_survival.pop_back();
+                }
+            }
+            while (pair_log.size() > m.num_pair_log) {
+                pair_op op = pair_log.back();
+                pair_log.pop_back();
+                if (op.added) {
+                    set_pair_of(op.pair, NO_PAIR);
+                    pairs.pop_back();
+                    pair_active.pop_back();
+                } else {
+                    set_pair_of(op.pair, op.pair);
+                    pair_active[op.pair] = 1;
+                }
+            }
+        }
+
+        /*
+         * add a plus 1 rxn. a pair containing it can't be hit anymore.
+         */
+        void add_stored(rxn_idx rxn) {
+            stored.push_back(rxn);
+            is_stored[rxn] = 1;
+            if (hit_probs) {
+                stored_survival.push_back(
+                    ((stored_survival.size() > 0) ? stored_survival.back()
+                                                  : 1) *
+                    (1 - (*hit_probs)[rxn]));
+            }
+            if (col_genes) {
+                for (unsigned int gene : (*col_genes)[rxn]) {
+                    num_blocked_genes += (gene_refs[gene]++ == 0);
+                }
+            }
+            if (pair_of[rxn] != NO_PAIR) {
+                drop_pair(pair_of[rxn]);
+            }
+        }
+
+        bool hits_stored(const Cutset& cs) const {
+            for (rxn_idx rxn : cs.m_active_rxns) {
+                if (is_stored[rxn]) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void add_pair(const rxn_pair& rxns) {
+            pair_log.push_back(pair_op{pairs.size(), true});
+            pairs.push_back(rxns);
+            pair_active.push_back(1);
+            set_pair_of(pairs.size() - 1, pairs.size() - 1);
+        }
+
+        void drop_pair(size_t pair) {
+            pair_log.push_back(pair_op{pair, false});
+            pair_active[pair] = 0;
+            set_pair_of(pair, NO_PAIR);
+        }
+
+        /*
+         * the other rxn of the pair of rxn
+         */
+        rxn_idx get_partner(rxn_idx rxn) const {
+            const rxn_pair& rxns = pairs[pair_of[rxn]];
+            return (rxns.first == rxn) ? rxns.second : rxns.first;
+        }
+
+        /*
+         * whether cs contains both rxns of any active pair
+         */
+        bool contains_pair(const Cutset& cs) const {
+            for (rxn_idx rxn : cs.m_active_rxns) {
+                if ((pair_of[rxn] != NO_PAIR) && cs.has_rxn(get_partner(rxn))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+      private:
+        void set_pair_of(size_t pair, size_t value) {
+            pair_of[pairs[pair].first] = value;
+            pair_of[pairs[pair].second] = value;
+        }
+    };
+
+    /*
+     * allocate the contributions of the MCSs, the powers of p and 1 - p and
+     * the derivatives for the attribution
+     */
+    void init_attribution(unsigned int max_d) {
+        m_mcs_contributions.assign(m_MCSs.size(), 0);
+        m_attribution_hit.resize(m_r_reduced);
+        for (size_t col = 0; col < m_r_reduced; col++) {
+            unsigned int n = (m_compressed) ? m_compr_rxn_counts[col] : 1;
+            m_attribution_hit[col] = -expm1l(n * log1pl(-m_attribution_p));
+        }
+        m_col_derivatives.assign(m_r_reduced, 0);
+        m_event_sum = 0;
+        m_pow_p.assign(max_d + 1, 1);
+        m_pow_q.assign(m_r + 1, 1);
+        for (size_t i = 1; i < m_pow_p.size(); i++) {
+            m_pow_p[i] = m_pow_p[i - 1] * m_attribution_p;
+        }
+        for (size_t i = 1; i < m_pow_q.size(); i++) {
+            m_pow_q[i] = m_pow_q[i - 1] * (1 - m_attribution_p);
+        }
+    }
+
+    /*
+     * probability of the event of a recursion call with heterogeneous
+     * probabilities (see set_rxn_probs) including the sign of the
+     * inclusion-exclusion: the columns in Cs hit, the plus 1 rxns not hit
+     * and none of the active pairs hit completely
+     */
+    long double get_event_probability(const rxn_idx* Cs, const rxn_idx* Cs_end,
+                                      unsigned int depth,
+                                      const recursion_state& state) const {
+        long double prob = (depth % 2) ? 1 : -1;
+        for (const rxn_idx* rxn = Cs; rxn != Cs_end; rxn++) {
+            prob *= m_hit_probs[*rxn];
+        }
+        if (state.stored_survival.size() > 0) {
+            prob *= state.stored_survival.back();
+        }
+        for (size_t p = 0; p < state.pairs.size(); p++) {
+            if (state.pair_active[p]) {
+                prob *= 1 - m_hit_probs[state.pairs[p].first] *
+                                m_hit_probs[state.pairs[p].second];
+            }
+        }
+        return prob;
+    }
+
+    /*
+     * add the derivatives of the probability of the event of a recursion call
+     * (for p of the attribution, incl. the sign) by the probabilities h_c of
+     * the columns being hit. the event is a product of h_c for the columns in
+     * Cs, 1 - h_c for the plus 1 columns, (1 - p)^n for the n essential rxns
+     * and 1 - h_c * h_c' for the active pairs --> the derivative by h_c is
+     * the probability divided by the factor of c times its derivative.
+     */
+    void add_event_derivatives(const rxn_idx* Cs, const rxn_idx* Cs_end,
+                               unsigned int depth, size_t plus1_rxns,
+                               recursion_state& state) const {
+        const vector<long double>& hit = m_attribution_hit;
+        long double prob = ((depth % 2) ? 1 : -1) * m_pow_q[plus1_rxns];
+        for (const rxn_idx* rxn = Cs; rxn != Cs_end; rxn++) {
+            prob *= hit[*rxn];
+        }
+        for (size_t i = 0; i < state.pairs.size(); i++) {
+            if (state.pair_active[i]) {
+                prob *= 1 - hit[state.pairs[i].first] *
+                                hit[state.pairs[i].second];
+            }
+        }
+        state.event_sum += prob;
+        for (const rxn_idx* rxn = Cs; rxn != Cs_end; rxn++) {
+            state.col_derivatives[*rxn] += prob / hit[*rxn];
+        }
+        for (rxn_idx rxn : state.stored) {
+            state.col_derivatives[rxn] -= prob / (1 - hit[rxn]);
+        }
+        for (size_t i = 0; i < state.pairs.size(); i++) {
+            if (state.pair_active[i]) {
+                rxn_idx x = state.pairs[i].first, y = state.pairs[i].second;
+                long double factor = 1 - hit[x] * hit[y];
+                state.col_derivatives[x] -= prob * hit[y] / factor;
+                state.col_derivatives[y] -= prob * hit[x] / factor;
+            }
+        }
+    }
+
+    /*
+     * start the recursion for the top-level MCS j. the arena of the thread is
+     * reset after every top-level subtree.
+     */
+    void start_recursion(size_t j, unsigned int max_d, bool use_cache,
+                         recursion_state& state) {
+        state.arena.reset();
+        state.contribution = 0;
+        GET_CARDINALITIES(j, m_MCSs[j].m_active_rxns.data(),
+                          m_MCSs[j].CARDINALITY(), max_d, 1, use_cache, state);
+        check_count_overflow();
+        if (m_mcs_contributions.size() > 0) {
+            m_mcs_contributions[j] = state.contribution;
+        }
+        if (m_prefix_tables.size() > 0) {
+#pragma omp critical(prefix_tables)
+            { state.counts.flush(m_prefix_tables[m_MCSs[j].CARDINALITY()]); }
+        }
+    }
+
+    /*
+     * handle a count overflow in the recursion of the calling thread (see
+     * count_overflow): stop the program or only record it
+     */
+    void check_count_overflow() {
+        const char* where = count_overflow();
+        if (!where) {
+            return;
+        }
+        count_overflow() = nullptr;
+        if (m_exit_on_overflow) {
+            cout << "Error: count overflow in " << where << endl;
+            exit(EXIT_FAILURE);
+        }
+#pragma omp atomic write
+        m_count_overflow = true;
+    }
+
+    /*
+     * one empty result table per cardinality of the first
+     * last_MCS_to_consider MCSs (the subtrees add to them instead of
+     * m_cd_table). without MCSs <= d0 only the prefix of the MCS1 is left.
+     */
+    void init_prefix_tables(size_t last_MCS_to_consider) {
+        size_t max_card =
+            (last_MCS_to_consider == 0)
+                ? 1
+                : m_MCSs[last_MCS_to_consider - 1].CARDINALITY();
+        m_prefix_tables.assign(max_card + 1,
+                               Matrix<wide_count>(m_cd_table.size(),
+                                                  vector<wide_count>(m_r, 0)));
+        m_prefix_num_MCSs.assign(max_card + 1, 0);
+        m_prefix_num_MCSs[1] = m_num_mcs1;
+        for (size_t i = 0; i < last_MCS_to_consider; i++) {
+            m_prefix_num_MCSs[m_MCSs[i].CARDINALITY()]++;
+        }
+    }
+
+    /*
+     * turn the tables per cardinality into running sums starting with the
+     * MCS1 (i.e. the tables of the prefixes). the last one is the result
+     * table of all MCSs.
+     */
+    void finish_prefix_tables() {
+        for (size_t card = 1; card < m_prefix_tables.size(); card++) {
+            for (size_t Mj = 0; Mj < m_cd_table.size(); Mj++) {
+                for (size_t a = 0; a < m_cd_table[Mj].size(); a++) {
+                    m_cd_table[Mj][a] += m_prefix_tables[card][Mj][a];
+                }
+            }
+            m_prefix_tables[card] = m_cd_table;
+            m_prefix_num_MCSs[card] += m_prefix_num_MCSs[card - 1];
+        }
+    }
+
+    /*
+     * PoF bounds for every prefix of the MCSs (see set_prefixes). the MCSs
+     * of a prefix up to dm' are complete up to dm' (or up to dm, whichever
+     * is smaller).
+     */
+    void print_prefix_results(double p, unsigned int dm) {
+        cout << "\nPoF for the MCSs up to every cardinality dm':\n" << endl;
+        Table table{{"dm'", "MCSs", "lower bound", "polynomial PoF",
+                     "upper bound"},
+                    {5, 12, 25, 25, 25},
+                    {"%.5g", "%.10g", "%.15e", "%.15e", "%.15e"}};
+        table.print_header();
+        // beyond the largest cardinality <= d0 the prefixes hold all MCSs
+        // considered by the recursion
+        size_t last_card = (dm > 0) ? min(dm, m_max_d)
+                                    : m_prefix_tables.size() - 1;
+        for (size_t card = 1; card <= last_card; card++) {
+            size_t i = min(card, m_prefix_tables.size() - 1);
+            m_cd_table.swap(m_prefix_tables[i]);
+            double lower, upper;
+            tie(lower, upper) = get_PoF_bounds(p, card);
+            double polynomial =
+                get<0>(get_final_PoF(convert_table(m_cd_table), p));
+            m_cd_table.swap(m_prefix_tables[i]);
+            table.print_row(vector<double>{(double)card,
+                                           (double)m_prefix_num_MCSs[i],
+                                           lower, polynomial, upper});
+        }
+        cout << string(22, '-') << endl;
+    }
+
+    /*
+     * thread-local counters for the entries of the result table the
+     * recursion can reach: the union of MCSs covers at most span (uncompressed)
+     * rxns or genes --> Mj <= span and the plus 1 rxns are between the MCS1
+     * and the MCS1 + span.
+     */
+    Accumulator make_accumulator() const {
+        vector<char> in_MCS(m_r_reduced, 0);
+        for (const Cutset& MCS : m_MCSs) {
+            for (rxn_idx rxn_id : MCS.m_active_rxns) {
+                in_MCS[rxn_id] = 1;
+            }
+        }
+        size_t span = 0, offset = 0;
+        if (m_gene_level) {
+            set<unsigned int> genes;
+            for (size_t col = 0; col < m_r_reduced; col++) {
+                if (in_MCS[col]) {
+                    genes.insert(m_col_genes[col].begin(),
+                                 m_col_genes[col].end());
+                }
+            }
+            span = genes.size();
+            offset = m_num_mcs1_uncompressed;
+        } else if (m_compressed) {
+            for (size_t col = 0; col < m_r_reduced; col++) {
+                span += in_MCS[col] * m_compr_rxn_counts[col];
+            }
+            offset = m_num_mcs1_uncompressed;
+        } else {
+            span = count(in_MCS.begin(), in_MCS.end(), 1);
+            offset = m_num_mcs1;
+        }
+        return Accumulator(min(m_cd_table.size(), span), span + 1, m_r,
+                           offset);
+    }
+
+    /*
+     * state for a thread of the recursion (sized for the current result
+     * table and MCSs)
+     */
+    recursion_state make_recursion_state() const {
+        Accumulator counts = make_accumulator();
+        recursion_state state(m_r_reduced, counts);
+        if (m_heterogeneous) {
+            state.hit_probs = &m_hit_probs;
+        }
+        if (m_gene_level) {
+            state.col_genes = &m_col_genes;
+            state.gene_refs = m_essential_gene_refs;
+            state.num_blocked_genes = m_num_mcs1_uncompressed;
+        }
+        if (m_max_order > 0) {
+            state.top_order_counts = counts;
+        }
+        if (m_attribution_hit.size() > 0) {
+            state.col_derivatives.assign(m_r_reduced, 0);
+        }
+        return state;
+    }
+
+    /*
+     * add the results of a thread to m_cd_table (and the other results of
+     * the recursion) and reset them
+     */
+    void add_recursion_state(recursion_state& state) {
+        state.counts.flush(m_cd_table);
+        m_hetero_sum += state.hetero_sum;
+        state.hetero_sum = 0;
+        for (size_t col = 0; col < state.col_derivatives.size(); col++) {
+            m_col_derivatives[col] += state.col_derivatives[col];
+            state.col_derivatives[col] = 0;
+        }
+        m_event_sum += state.event_sum;
+        state.event_sum = 0;
+        if (m_max_order > 0) {
+            state.top_order_counts.flush(m_top_order_table);
+        }
+    }
+
+    /*
+     * set up the result table for a recursion whose top-level subtrees are
+     * started from outside (see batch.hpp): d0 and the MCS1 as in
+     * get_cardinalities. returns the number of top-level MCSs (i.e. the
+     * ones with d <= d0).
+     */
+    size_t prepare_recursion(unsigned int max_d) {
+        max_d = init_cd_table(max_d);
+        if (m_MCS_d1_present) {
+            add_MCS1_to_table();
+        }
+        size_t last_MCS_to_consider = 0;
+        while ((last_MCS_to_consider < m_MCSs.size()) &&
+               (m_MCSs[last_MCS_to_consider].CARDINALITY() <= max_d)) {
+            last_MCS_to_consider++;
+        }
+        return last_MCS_to_consider;
+    }
+
+    /*
+     * start the recursion for the first last_MCS_to_consider MCSs and add the
+     * results to m_cd_table
+     */
+    void run_recursion(size_t last_MCS_to_consider, unsigned int max_d,
+                       unsigned int num_threads, bool use_cache,
+                       bool show_progress = true) {
+        // setup progress bar (it writes to cout)
+        show_progress = show_progress && (m_log == &cout);
+        progressbar prog_bar(last_MCS_to_consider, show_progress);
+        vector<recursion_state> states;
+        states.reserve(num_threads);
+        for (unsigned int t = 0; t < num_threads; t++) {
+            states.push_back(make_recursion_state());
+        }
+        if (m_max_order > 0) {
+            m_top_order_table = Matrix<wide_count>(
+                m_cd_table.size(), vector<wide_count>(m_r, 0));
+        }
+// initialize openMP for loop
+#pragma omp parallel for num_threads(num_threads)
+        for (size_t i = 0; i < last_MCS_to_consider; i++) {
+            // start with high cardinality MCSs first --> loop speeds up towards
+            // the end instead of slowing down --> nicer.
+            size_t j = last_MCS_to_consider - i - 1;
+#pragma omp task
+            {
+                // start recursion
+                start_recursion(j, max_d, use_cache,
+                                states[omp_get_thread_num()]);
+                if (show_progress) {
+#pragma omp critical
+                    { prog_bar.update(); }
+                }
+            }
+        }
+        for (recursion_state& state : states) {
+            add_recursion_state(state);
+        }
+        if (show_progress) {
+            // add new lines after progress bar
+            *m_log << "\n\n" << endl;
+        }
+    }
+
+    /*
+     * the recursion truncated at order k = m_max_order yields the result
+     * table of order k and the table of order k - 1 is obtained by removing
+     * the contributions of the calls at depth k. a recursion call includes
+     * the terms of its subtree, so cutting the subtree off overestimates the
+     * (non-negative) result of a call and the error changes its sign at
+     * every level up to the top --> odd orders give upper bounds and even
+     * ones lower bounds (for every d <= d0). afterwards, m_cd_table holds
+     * the lower bound and m_cd_table_upper the upper one.
+     */
+    void split_bonferroni_tables() {
+        Matrix<wide_count> prev_order = m_cd_table;
+        for (size_t Mj = 0; Mj < prev_order.size(); Mj++) {
+            for (size_t a = 0; a < prev_order[Mj].size(); a++) {
+                prev_order[Mj][a] -= m_top_order_table[Mj][a];
+            }
+        }
+        if (m_max_order % 2) {
+            m_cd_table_upper = m_cd_table;
+            m_cd_table = prev_order;
+        } else {
+            m_cd_table_upper = prev_order;
+        }
+        m_top_order_table.clear();
+        *m_log << "Inclusion-exclusion truncated at order " << m_max_order
+             << " --> F(d) below is the lower bound of order "
+             << m_max_order - (m_max_order % 2) << " and the upper bound "
+             << "uses order " << m_max_order - 1 + (m_max_order % 2) << "\n"
+             << endl;
+    }
+
+    /*
+     * same as run_recursion, but the results of every top-level subtree are
+     * added to m_cd_table as soon as it is finished. a reporter thread prints
+     * the PoF bounds of the finished subtrees every m_report_interval seconds
+     * and aborts the recursion after m_time_limit seconds. the results of
+     * aborted subtrees are discarded and the MCSs are stored in m_unfinished
+     * instead.
+     */
+    void run_recursion_anytime(size_t last_MCS_to_consider,
+                               unsigned int max_d, unsigned int num_threads,
+                               bool use_cache) {
+        atomic<bool> stop(false);
+        vector<recursion_state> states;
+        states.reserve(num_threads);
+        for (unsigned int t = 0; t < num_threads; t++) {
+            states.emplace_back(m_r_reduced, make_accumulator());
+            states.back().stop = &stop;
+        }
+        vector<char> finished(last_MCS_to_consider, 0);
+        size_t num_finished = 0;
+        // guards m_cd_table and finished; the reporter waits on cv
+        mutex mtx;
+        condition_variable cv;
+        bool done = false;
+
+        typedef chrono::steady_clock clock;
+        clock::time_point start = clock::now();
+        auto to_duration = [](double seconds) {
+            return chrono::duration_cast<clock::duration>(
+                chrono::duration<double>(seconds));
+        };
+        thread reporter([&]() {
+            clock::time_point deadline = start + to_duration(m_time_limit);
+            clock::time_point next_report =
+                start + to_duration(m_report_interval);
+            unique_lock<mutex> lock(mtx);
+            while (!done) {
+                clock::time_point wake = clock::time_point::max();
+                if (m_report_interval > 0) {
+                    wake = next_report;
+                }
+                if ((m_time_limit > 0) && (deadline < wake)) {
+                    wake = deadline;
+                }
+                if (cv.wait_until(lock, wake, [&]() { return done; })) {
+                    break;
+                }
+                double elapsed =
+                    chrono::duration<double>(clock::now() - start).count();
+                char report[256];
+                if ((m_time_limit > 0) && (clock::now() >= deadline)) {
+                    stop = true;
+                    snprintf(report, sizeof(report),
+                             "Time limit of %g s reached after %lu of %lu "
+                             "MCSs\n",
+                             m_time_limit, num_finished, finished.size());
+                    *m_log << report << endl;
+                    break;
+                }
+                m_unfinished = get_unfinished_table(finished);
+                check_count_overflow();
+                double lower, upper;
+                tie(lower, upper) = get_PoF_bounds(m_report_p, m_report_dm);
+                snprintf(report, sizeof(report),
+                         "[%.1f s] %lu of %lu MCSs done: %.15e <= PoF <= "
+                         "%.15e",
+                         elapsed, num_finished, finished.size(), lower, upper);
+                *m_log << report << endl;
+                next_report += to_duration(m_report_interval);
+            }
+        });
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+        for (size_t i = 0; i < last_MCS_to_consider; i++) {
+            size_t j = last_MCS_to_consider - i - 1;
+            if (stop) {
+                continue;
+            }
+            recursion_state& state = states[omp_get_thread_num()];
+            start_recursion(j, max_d, use_cache, state);
+            if (stop) {
+                // the subtree might have been aborted
+                state.counts.clear();
+            } else {
+                lock_guard<mutex> lock(mtx);
+                state.counts.flush(m_cd_table);
+                finished[j] = 1;
+                num_finished++;
+            }
+        }
+        {
+            lock_guard<mutex> lock(mtx);
+            done = true;
+        }
+        cv.notify_all();
+        reporter.join();
+        m_unfinished = get_unfinished_table(finished);
+        check_count_overflow();
+        if (m_unfinished.size() > 0) {
+            *m_log << "The bounds account for the "
+                   << last_MCS_to_consider - num_finished
+                   << " unfinished MCSs\n"
+                   << endl;
+        }
+    }
+
+    /*
+     * the event "MCS j is hit" for every top-level MCS j whose subtree is not
+     * finished as entries (Mj, a) of the result table, i.e. all ways of
+     * deleting Mj of the N uncompressed rxns in the columns of the MCS (at
+     * least one per column) while not deleting the other a = N - Mj. the
+     * subtree of MCS j counts a subset of this event (MCS j is hit, but none
+     * of the MCSs before it) --> an upper bound for its contribution.
+     */
+    Counter get_unfinished_table(const vector<char>& finished) const {
+        Counter table;
+        for (size_t j = 0; j < finished.size(); j++) {
+            if (finished[j]) {
+                continue;
+            }
+            const Cutset& MCS = m_MCSs[j];
+            if (!m_compressed) {
+                table[make_pair(MCS.CARDINALITY(), 0)]++;
+                continue;
+            }
+            vector<unsigned int> NCRs;
+            for (rxn_idx rxn : MCS.m_active_rxns) {
+                NCRs.push_back(m_compr_rxn_counts[rxn]);
+            }
+            sort(NCRs.begin(), NCRs.end());
+            size_t N = sum_vec(NCRs);
+            auto Mjs_counts = get_Mjs_and_counts(NCRs);
+            for (size_t i = 0; i < Mjs_counts.first.size(); i++) {
+                size_t Mj = Mjs_counts.first[i];
+                table[make_pair(Mj, N - Mj)] += Mjs_counts.second[i];
+            }
+        }
+        return table;
+    }
+
+    /*
+     * number of uncompressed rxns in the reduced network (i.e. without
+     * essential rxns)
+     */
+    size_t get_num_reduced_rxns() const {
+        return (m_compressed) ? sum_vec(m_compr_rxn_counts) : m_r_reduced;
+    }
+
+    /*
+     * whether the reduced network is small enough for the exhaustive engine
+     */
+    bool exhaustive_possible(unsigned int max_cols) const {
+        return (m_MCSs.size() > 0) && (m_r_reduced <= max_cols) &&
+               (m_r_reduced <= EXHAUSTIVE_MAX_COLS) &&
+               (get_num_reduced_rxns() <= EXHAUSTIVE_MAX_RXNS);
+    }
+
+    /*
+     * count the lethal deletion sets of the reduced network exhaustively
+     * (see exhaustive.hpp) and add them to the result table. every lethal
+     * set of k out of the s rxns in the reduced network corresponds to the
+     * event "k specific rxns deleted and the other s - k (and the essential
+     * rxns) not deleted" --> entry (Mj=k, a=s-k). uses all MCSs (not only
+     * those with d <= d0); entries with Mj beyond the table are dropped.
+     */
+    void run_exhaustive(unsigned int num_threads) {
+        vector<long> lethal = count_lethal_sets(
+            m_MCSs, m_r_reduced,
+            (m_compressed) ? m_compr_rxn_counts : vector<unsigned int>(),
+            num_threads);
+        size_t s = lethal.size() - 1;
+        size_t num_mcs1 = (m_compressed) ? m_num_mcs1_uncompressed : m_num_mcs1;
+        for (size_t k = 1; (k <= s) && (k <= m_cd_table.size()); k++) {
+            m_cd_table[k - 1][s - k + num_mcs1] += lethal[k];
+        }
+    }
+
+    /*
+     * build a ZDD of the first last_MCS_to_consider MCSs and count the lethal
+     * deletion sets of the reduced network for every cardinality up to d0
+     * (see zdd.hpp) instead of running the recursion. MCSs with more than d0
+     * columns can't be contained in any deletion set with up to d0 rxns -->
+     * the counts are exact. they are scored directly in score_cd_table2 and
+     * get_zdd_PoF.
+     */
+    void run_zdd(size_t last_MCS_to_consider, unsigned int max_d,
+                 const string& order) {
+        vector<Cutset> MCSs(m_MCSs.begin(),
+                            m_MCSs.begin() + last_MCS_to_consider);
+        vector<rxn_idx> cols = get_zdd_variable_order(MCSs, m_r_reduced, order);
+        vector<unsigned int> levels(m_r_reduced), num_rxns(cols.size());
+        m_zdd_num_rxns = 0;
+        for (size_t level = 0; level < cols.size(); level++) {
+            levels[cols[level]] = level;
+            num_rxns[level] =
+                (m_compressed) ? m_compr_rxn_counts[cols[level]] : 1;
+            m_zdd_num_rxns += num_rxns[level];
+        }
+        vector<vector<unsigned int>> sets;
+        sets.reserve(MCSs.size());
+        for (const Cutset& cs : MCSs) {
+            vector<unsigned int> set;
+            for (rxn_idx rxn : cs.m_active_rxns) {
+                set.push_back(levels[rxn]);
+            }
+            sort(set.begin(), set.end());
+            sets.push_back(set);
+        }
+        ZDD zdd(num_rxns);
+        ZDD::node_id root = zdd.build_family(sets);
+        m_lethal_counts = zdd.count_lethal_sets(root, max_d);
+        *m_log << "ZDD with " << zdd.size() << " nodes for " << cols.size()
+             << " columns\n"
+             << endl;
+    }
+
+    /*
+     * estimate the fraction of lethal deletion sets by sampling num_samples
+     * sets for every number of deletions in the columns of the MCSs that is
+     * relevant for p (see sampling.hpp). uses all MCSs --> has to be called
+     * before get_cardinalities (which might drop MCSs with d > d0). the
+     * estimates replace F(d) for the d that are not covered exactly by the
+     * recursion (see get_sampled_score).
+     */
+    void run_sampling(double p, size_t num_samples, uint64_t seed,
+                      unsigned int num_threads = 1) {
+        m_num_samples = num_samples;
+        m_sampled_rxns = get_num_reduced_rxns();
+        m_seed = seed;
+        unsigned int max_k = get_max_weighted_d(p);
+        *m_log << "Sampling " << num_samples << " deletion sets for up to "
+             << max_k << " deletions...\n"
+             << endl;
+        m_lethal_samples = sample_lethal_sets(
+            m_MCSs, m_r_reduced,
+            (m_compressed) ? m_compr_rxn_counts : vector<unsigned int>(),
+            max_k, num_samples, seed, num_threads);
+    }
+
+    /*
+     * answer whether the deletion sets in a file (one per line, '-' -->
+     * stdin) contain an MCS (see oracle.hpp) and print one line per deletion
+     * set. has to be called before the columns are changed (i.e. before
+     * merge_equivalent_rxns and get_cardinalities).
+     */
+    void answer_queries(const string& fname, unsigned int num_threads = 1) {
+        Lethality_oracle oracle(m_MCSs, m_r_reduced, m_mcs1_rxns,
+                                m_column_rxn_counts, m_r, m_column_names);
+        size_t num_invalid;
+        cout << "Lethality of the deletion sets (1: lethal, 0: not lethal):"
+             << endl;
+        if (fname == "-") {
+            num_invalid = oracle.answer(cin, cout, num_threads);
+        } else {
+            ifstream file(fname);
+            if (!file.is_open()) {
+                cout << "Error opening query file" << endl;
+                exit(EXIT_FAILURE);
+            }
+            num_invalid = oracle.answer(file, cout, num_threads);
+        }
+        if (num_invalid > 0) {
+            cerr << "Warning: " << num_invalid
+                 << " deletion sets could not be parsed" << endl;
+        }
+    }
+
+    /*
+     * create a calculator for the network with the (reduced) columns in
+     * background deleted (sorted, without duplicates): the MCSs containing
+     * them shrink to the remaining columns, which can make other MCSs
+     * non-minimal. an unshrunk MCS can only be a superset of a shrunk one
+     * (given that the MCSs are minimal) --> only the shrunk ones are
+     * normalized and the others are checked against them. index holds the
+     * MCSs of this calculator. MCSs that shrink to one column become
+     * essential. returns false if the background itself is lethal (i.e.
+     * contains an MCS).
+     */
+    bool get_scenario_calculator(const vector<rxn_idx>& background,
+                                 const MCS_index& index,
+                                 PoF_calculator& scen) const {
+        size_t num_cols = m_r_reduced - background.size();
+        vector<char> touched(m_MCSs.size(), 0);
+        for (rxn_idx col : background) {
+            for (unsigned int id : index.get_postings(col)) {
+                touched[id] = 1;
+            }
+        }
+        vector<Cutset> shrunk;
+        for (size_t i = 0; i < m_MCSs.size(); i++) {
+            if (touched[i]) {
+                shrunk.push_back(m_MCSs[i].remove_rxns(background));
+                if (shrunk.back().CARDINALITY() == 0) {
+                    return false;
+                }
+            }
+        }
+        shrunk = normalize_MCS_arr(move(shrunk), nullptr);
+        MCS_index shrunk_index(num_cols);
+        for (const Cutset& cs : shrunk) {
+            shrunk_index.add(cs);
+        }
+        MCS_index::query_buffer buf;
+        vector<Cutset> unshrunk;
+        unshrunk.reserve(m_MCSs.size() - shrunk.size());
+        for (size_t i = 0; i < m_MCSs.size(); i++) {
+            if (!touched[i]) {
+                Cutset cs = m_MCSs[i].remove_rxns(background);
+                if (shrunk_index.find_subset(cs, buf) < 0) {
+                    unshrunk.push_back(move(cs));
+                }
+            }
+        }
+        // both are sorted by cardinality
+        vector<Cutset> MCSs;
+        MCSs.reserve(shrunk.size() + unshrunk.size());
+        merge(shrunk.begin(), shrunk.end(), unshrunk.begin(), unshrunk.end(),
+              back_inserter(MCSs), [](const Cutset& a, const Cutset& b) {
+                  return a.CARDINALITY() < b.CARDINALITY();
+              });
+        // new essential columns
+        size_t num_mcs1 = 0;
+        for (; (num_mcs1 < MCSs.size()) && (MCSs[num_mcs1].CARDINALITY() == 1);
+             num_mcs1++) {
+            scen.m_mcs1_rxns.push_back(MCSs[num_mcs1].get_first_active_rxn());
+        }
+        sort(scen.m_mcs1_rxns.begin(), scen.m_mcs1_rxns.end());
+        scen.m_compressed = m_compressed;
+        scen.m_exit_on_overflow = m_exit_on_overflow;
+        scen.m_num_mcs1 = m_num_mcs1 + num_mcs1;
+        scen.m_num_mcs1_uncompressed = m_num_mcs1_uncompressed;
+        scen.m_MCS_d1_present = scen.m_num_mcs1 > 0;
+        scen.m_r_reduced = num_cols - num_mcs1;
+        if (m_compressed) {
+            // the rxns of deleted columns are gone and those of essential
+            // columns are added to the essential rxns
+            size_t num_deleted = 0, b = 0, e = 0;
+            for (rxn_idx col = 0; col < m_r_reduced; col++) {
+                if ((b < background.size()) && (background[b] == col)) {
+                    num_deleted += m_compr_rxn_counts[col];
+                    b++;
+                } else if ((e < num_mcs1) &&
+                           (scen.m_mcs1_rxns[e] == col - b)) {
+                    scen.m_num_mcs1_uncompressed += m_compr_rxn_counts[col];
+                    e++;
+                } else {
+                    scen.m_compr_rxn_counts.push_back(m_compr_rxn_counts[col]);
+                }
+            }
+            scen.m_r = m_r - num_deleted;
+        } else {
+            scen.m_r = m_r - background.size();
+        }
+        scen.m_MCSs.reserve(MCSs.size() - num_mcs1);
+        for (size_t i = num_mcs1; i < MCSs.size(); i++) {
+            scen.m_MCSs.push_back(MCSs[i].remove_rxns(scen.m_mcs1_rxns));
+        }
+        scen.m_nMCS_reduced = scen.m_MCSs.size();
+        scen.m_nMCS = scen.m_nMCS_reduced + scen.m_num_mcs1;
+        return true;
+    }
+
+    /*
+     * get_cardinalities for a calculator of a scenario (see run_scenarios):
+     * single-threaded and without output
+     */
+    void get_scenario_cardinalities(unsigned int max_d, bool use_cache,
+                                    unsigned int exhaustive_max_cols) {
+        max_d = init_cd_table(max_d);
+        if (m_MCS_d1_present) {
+            add_MCS1_to_table();
+        }
+        if (m_MCSs.size() == 0) {
+            return;
+        }
+        size_t last_MCS_to_consider = 0;
+        while ((last_MCS_to_consider < m_MCSs.size()) &&
+               (m_MCSs[last_MCS_to_consider].CARDINALITY() <= max_d)) {
+            last_MCS_to_consider++;
+        }
+        if (exhaustive_possible(exhaustive_max_cols)) {
+            m_max_d = m_r;
+            m_cd_table.resize(max(m_cd_table.size(), get_num_reduced_rxns()),
+                              vector<wide_count>(m_r, 0));
+            run_exhaustive(1);
+        } else {
+            run_recursion(last_MCS_to_consider, max_d, 1, use_cache, false);
+        }
+    }
+
+    /*
+     * conditional PoF for mutant backgrounds: every line of a file holds a
+     * set of deleted rxns (in any of the formats of answer_queries). the
+     * scenarios are run in parallel (one thread each) and share the index
+     * over the MCSs. MCSs with d > dm can shrink to d <= dm in a scenario -->
+     * the MCSs of a scenario are complete up to dm minus the number of
+     * deleted columns.
+     */
+    void run_scenarios(const string& fname, unsigned int max_d, double p,
+                       unsigned int dm, unsigned int num_threads = 1,
+                       bool use_cache = true,
+                       unsigned int exhaustive_max_cols = 26) {
+        ifstream file(fname);
+        if (!file.is_open()) {
+            cout << "Error opening scenario file" << endl;
+            exit(EXIT_FAILURE);
+        }
+        vector<string> backgrounds;
+        string line;
+        while (getline(file, line)) {
+            backgrounds.push_back(line);
+        }
+        file.close();
+        cout << "Running " << backgrounds.size() << " scenarios...\n" << endl;
+        Lethality_oracle oracle(m_MCSs, m_r_reduced, m_mcs1_rxns,
+                                m_column_rxn_counts, m_r, m_column_names);
+        // lower and upper bound per scenario (-1 --> invalid line)
+        vector<tuple<double, double>> bounds(backgrounds.size());
+        vector<size_t> num_deleted(backgrounds.size(), 0);
+        progressbar prog_bar(backgrounds.size(), true);
+#pragma omp parallel num_threads(num_threads)
+        {
+            vector<rxn_idx> background;
+#pragma omp for schedule(dynamic, 1)
+            for (size_t i = 0; i < backgrounds.size(); i++) {
+                int status = oracle.parse(backgrounds[i], background);
+                num_deleted[i] = background.size();
+                PoF_calculator scen;
+                if (status < 0) {
+                    bounds[i] = make_tuple(-1.0, -1.0);
+                } else if ((status > 0) ||
+                           !get_scenario_calculator(background,
+                                                    oracle.get_index(), scen)) {
+                    bounds[i] = make_tuple(1.0, 1.0);
+                } else {
+                    scen.get_scenario_cardinalities(max_d, use_cache,
+                                                    exhaustive_max_cols);
+                    unsigned int scen_dm =
+                        (dm > background.size()) ? dm - background.size() : 0;
+                    bounds[i] = scen.get_PoF_bounds(p, scen_dm);
+                }
+#pragma omp critical
+                { prog_bar.update(); }
+            }
+        }
+        cout << "\n\nConditional PoF per scenario (lethal backgrounds have "
+                "PoF=1):\n"
+             << endl;
+        Table table{{"scenario", "deleted columns", "lower bound",
+                     "upper bound"},
+                    {10, 20, 25, 25},
+                    {"%.5g", "%.5g", "%.15e", "%.15e"}};
+        table.print_header();
+        size_t num_invalid = 0;
+        for (size_t i = 0; i < backgrounds.size(); i++) {
+            if (get<0>(bounds[i]) < 0) {
+                num_invalid++;
+                continue;
+            }
+            table.print_row(vector<double>{(double)i + 1,
+                                           (double)num_deleted[i],
+                                           get<0>(bounds[i]),
+                                           get<1>(bounds[i])});
+        }
+        if (num_invalid > 0) {
+            cout << "\n" << num_invalid
+                 << " scenarios could not be parsed and were skipped" << endl;
+        }
+    }
+
+    /*
+     * largest d whose weight is not below WEIGHT_LIMIT (as in print_results)
+     */
+    unsigned int get_max_weighted_d(double p) const {
+        unsigned int max_d = 0;
+        for (size_t d = 1; d <= m_r; d++) {
+            if (binom_dist_weight(m_r, d, p) < WEIGHT_LIMIT) {
+                break;
+            }
+            max_d = d;
+        }
+        return max_d;
+    }
+
+    /*
+     * find groups of MCSs that don't share any reactions (i.e. the connected
+     * components of the MCS-reaction incidence graph) among the first
+     * last_MCS_to_consider MCSs. returns the MCS indices of every component
+     * (keeping their order), largest component first.
+     */
+    vector<vector<size_t>> find_MCS_components(size_t last_MCS_to_consider) {
+        // union-find over the reactions
+        vector<rxn_idx> parent(m_r_reduced);
+        for (rxn_idx rxn = 0; rxn < m_r_reduced; rxn++) {
+            parent[rxn] = rxn;
+        }
+        auto find_root = [&](rxn_idx rxn) {
+            while (parent[rxn] != rxn) {
+                parent[rxn] = parent[parent[rxn]]; // path halving
+                rxn = parent[rxn];
+            }
+            return rxn;
+        };
+        for (size_t i = 0; i < last_MCS_to_consider; i++) {
+            rxn_idx root = find_root(m_MCSs[i].get_first_active_rxn());
+            for (rxn_idx rxn : m_MCSs[i].m_active_rxns) {
+                parent[find_root(rxn)] = root;
+            }
+        }
+        // group MCSs by the root of their reactions
+        unordered_map<rxn_idx, size_t> comp_ids;
+        vector<vector<size_t>> components;
+        for (size_t i = 0; i < last_MCS_to_consider; i++) {
+            rxn_idx root = find_root(m_MCSs[i].get_first_active_rxn());
+            auto search = comp_ids.find(root);
+            if (search == comp_ids.end()) {
+                comp_ids[root] = components.size();
+                components.push_back(vector<size_t>{i});
+            } else {
+                components[search->second].push_back(i);
+            }
+        }
+        stable_sort(components.begin(), components.end(),
+                    [](const vector<size_t>& a, const vector<size_t>& b) {
+                        return a.size() > b.size();
+                    });
+        return components;
+    }
+
+    /*
+     * create a calculator for a single component with the MCSs renumbered to
+     * the reactions of the component only. essential rxns are not part of
+     * any component and are added to the combined table later.
+     */
+    PoF_calculator get_component_calculator(const vector<size_t>& MCS_ids,
+                                            unsigned int max_d) const {
+        PoF_calculator comp;
+        comp.m_compressed = m_compressed;
+        comp.m_r = m_r;
+        comp.m_log = m_log;
+        comp.m_exit_on_overflow = m_exit_on_overflow;
+        // map reactions to their index within the component
+        unordered_map<rxn_idx, rxn_idx> local_idx;
+        for (size_t i : MCS_ids) {
+            for (rxn_idx rxn : m_MCSs[i].m_active_rxns) {
+                local_idx.insert({rxn, 0});
+            }
+        }
+        vector<rxn_idx> rxns;
+        rxns.reserve(local_idx.size());
+        for (const auto& elem : local_idx) {
+            rxns.push_back(elem.first);
+        }
+        sort(rxns.begin(), rxns.end());
+        for (rxn_idx i = 0; i < rxns.size(); i++) {
+            local_idx[rxns[i]] = i;
+            if (m_compressed) {
+                comp.m_compr_rxn_counts.push_back(m_compr_rxn_counts[rxns[i]]);
+            }
+        }
+        comp.m_r_reduced = rxns.size();
+        comp.m_MCSs.reserve(MCS_ids.size());
+        for (size_t i : MCS_ids) {
+            Cutset cs(comp.m_r_reduced);
+            for (rxn_idx rxn : m_MCSs[i].m_active_rxns) {
+                cs.m_active_rxns.push_back(local_idx[rxn]);
+            }
+            comp.m_MCSs.push_back(cs);
+        }
+        comp.m_nMCS = comp.m_nMCS_reduced = MCS_ids.size();
+        comp.m_max_d = max_d;
+        comp.m_cd_table =
+            Matrix<wide_count>(max_d, vector<wide_count>(m_r, 0));
+        return comp;
+    }
+
+    /*
+     * run the recursion separately for every independent component (i.e.
+     * groups of MCSs that don't share reactions) and combine the results.
+     * for independent components, the probability that none of them is hit
+     * factorizes: 1 - F = prod_c (1 - F_c). the entries of the result table
+     * stand for the events "Mj specific rxns deleted and a specific rxns not
+     * deleted" --> the product of two entries of components with disjoint
+     * rxns is the entry (Mj1 + Mj2, a1 + a2) and the tables can be combined
+     * by a convolution truncated at d0.
      */
-    void add_MCS1_to_table() {
-        unsigned int num_mcs1 =
-            (m_compressed) ? m_num_mcs1_uncompressed : m_num_mcs1;
-        size_t Mj = 1; // cardinality of MCS1 = 1
-        for (size_t a = 0; a < num_mcs1; a++) {
-            m_cd_table[Mj - 1][a]++;
+    void get_cardinalities_by_component(size_t last_MCS_to_consider,
+                                        unsigned int max_d,
+                                        unsigned int num_threads,
+                                        bool use_cache,
+                                        unsigned int exhaustive_max_cols) {
+        vector<vector<size_t>> components =
+            find_MCS_components(last_MCS_to_consider);
+        *m_log << "Found " << components.size()
+             << " independent component(s); the largest one has "
+             << components[0].size() << " MCSs\n"
+             << endl;
+        vector<Counter> comp_tables(components.size());
+        // components larger than their share of the threads are processed
+        // one after the other using all threads; the rest in parallel with
+        // one thread each
+        size_t num_large = 0;
+        while ((num_large < components.size()) && (num_threads > 1) &&
+               (components[num_large].size() * num_threads >
+                last_MCS_to_consider)) {
+            num_large++;
+        }
+        for (size_t c = 0; c < num_large; c++) {
+            PoF_calculator comp = get_component_calculator(components[c], max_d);
+            if (comp.exhaustive_possible(exhaustive_max_cols)) {
+                comp.run_exhaustive(num_threads);
+            } else {
+                comp.run_recursion(comp.m_MCSs.size(), max_d, num_threads,
+                                   use_cache, false);
+            }
+            m_count_overflow = m_count_overflow || comp.m_count_overflow;
+            comp_tables[c] = comp.get_sparse_cd_table();
+        }
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+        for (size_t c = num_large; c < components.size(); c++) {
+            PoF_calculator comp = get_component_calculator(components[c], max_d);
+            if (comp.exhaustive_possible(exhaustive_max_cols)) {
+                comp.run_exhaustive(1);
+            } else {
+                comp.run_recursion(comp.m_MCSs.size(), max_d, 1, use_cache,
+                                   false);
+            }
+            if (comp.m_count_overflow) {
+#pragma omp atomic write
+                m_count_overflow = true;
+            }
+            comp_tables[c] = comp.get_sparse_cd_table();
+        }
+        // combine the tables: F = 1 - prod_c (1 - F_c)
+        // --> iteratively F <- F + F_c - F * F_c
+        Counter combined;
+        for (const Counter& comp_table : comp_tables) {
+            Counter product = multiply_sparse_tables(combined, comp_table,
+                                                     max_d);
+            for (const auto& elem : comp_table) {
+                combined[elem.first] += elem.second;
+            }
+            for (const auto& elem : product) {
+                combined[elem.first] -= elem.second;
+            }
+        }
+        // add to result table. essential rxns are not deleted in any of
+        // these events (see plus1_rxns in GET_CARDINALITIES)
+        size_t num_mcs1 = (m_compressed) ? m_num_mcs1_uncompressed : m_num_mcs1;
+        for (const auto& elem : combined) {
+            m_cd_table[elem.first.first - 1][elem.first.second + num_mcs1] +=
+                elem.second;
         }
     }
 
     /*
-     * pretty-print result table (e.g. for debugging)
+     * return the non-zero entries of the result table as (Mj, a) --> count
      */
-    void print_cd_table() const {
-        Table table({"|Mj|", "a", "#"}, {15, 15, 15}, {"%.5g", "%g", "%g"}
-                    // uses scientific fmt in case the numbers
-                    ); // get too large
-        table.print_header();
+    Counter get_sparse_cd_table() const {
+        Counter table;
         for (size_t Mj = 0; Mj < m_cd_table.size(); Mj++) {
             for (size_t a = 0; a < m_cd_table[Mj].size(); a++) {
-                auto count = m_cd_table[Mj][a];
-                if (count != 0) {
-                    // actual Mj is larger by 1 (0-based indexing)
-                    table.print_row(vector<double>{Mj + 1, a, count});
+                if (m_cd_table[Mj][a] != 0) {
+                    table[make_pair(Mj + 1, a)] = m_cd_table[Mj][a];
                 }
             }
         }
+        return table;
     }
 
     /*
-     * main function preparing for and then invoking recursion
+     * multiply two sparse result tables of components with disjoint rxns
+     * (i.e. add up Mjs and as). entries with Mj > max_d are dropped.
      */
-    void get_cardinalities(unsigned int max_d, unsigned int num_threads = 1,
-                           bool use_cache = true) {
-        // check if d0 supplied at cmd line is greater than the number of rxns
-        if ((max_d > m_r) || (max_d == 0)) {
-            max_d = m_r;
+    static Counter multiply_sparse_tables(const Counter& table1,
+                                          const Counter& table2,
+                                          unsigned int max_d) {
+        Counter product;
+        for (const auto& elem1 : table1) {
+            for (const auto& elem2 : table2) {
+                size_t Mj = elem1.first.first + elem2.first.first;
+                if (Mj > max_d) {
+                    // entries are sorted by Mj
+                    break;
+                }
+                product[make_pair(Mj, elem1.first.second + elem2.first.second)] +=
+                    elem1.second * elem2.second;
+            }
         }
-        m_max_d = max_d;
-        // initialize result table with rows for every 0 < d <= d0 and columns
-        // for every reaction (representing plus 1 rxns)
-        m_cd_table = Matrix<long>(max_d, vector<long>(m_r, 0));
-        size_t last_MCS_to_consider = m_MCSs.size();
-        if (m_MCS_d1_present) {
-            // add MCS1 to table
-            cout << "adding MCS(d=1) to table...\n" << endl;
-            add_MCS1_to_table();
-            if (m_MCSs.size() == 0) {
-                // MCS matrix was reduced to nothing --> only MCS with d=1 in
-                // original matrix
-                cout << "no MCS with d>1 present --> no recursion required\n"
-                     << endl;
-                return;
+        return product;
+    }
+
+    /*
+     * pre-processing for better memory locality: reactions that don't appear
+     * in any of the first last_MCS_to_consider MCSs (i.e. d <= d0) are
+     * dropped and the remaining ones are renumbered by decreasing frequency
+     * --> frequently used reactions get low and dense indices. the MCSs with
+     * d > d0 are discarded as they are not used in the recursion anyway.
+     * the order of the MCSs is kept: with d0 < r the entries of the result
+     * table beyond d0 (and thus the polynomial PoF) depend on it.
+     */
+    void reorder_for_locality(size_t last_MCS_to_consider) {
+        m_MCSs.erase(m_MCSs.begin() + last_MCS_to_consider, m_MCSs.end());
+        m_nMCS_reduced = m_MCSs.size();
+        // count reaction frequencies
+        vector<size_t> freqs(m_r_reduced, 0);
+        for (const Cutset& cs : m_MCSs) {
+            for (rxn_idx rxn : cs.m_active_rxns) {
+                freqs[rxn]++;
             }
         }
-        cout << "Starting recursion...\n" << endl;
-        // check if there are MCS with d > d0 (max_d)
-        if (m_MCSs.back().CARDINALITY() > max_d) {
-            // get the last element with d <= max_d
-            for (size_t i = 0; i < m_MCSs.size(); i++) {
-                if (m_MCSs[i].CARDINALITY() > max_d) {
-                    last_MCS_to_consider = i;
+        vector<rxn_idx> order;
+        order.reserve(m_r_reduced);
+        for (rxn_idx rxn = 0; rxn < m_r_reduced; rxn++) {
+            if (freqs[rxn] > 0) {
+                order.push_back(rxn);
+            }
+        }
+        stable_sort(order.begin(), order.end(), [&](rxn_idx a, rxn_idx b) {
+            return freqs[a] > freqs[b];
+        });
+        // map old to new indices
+        vector<rxn_idx> new_idx(m_r_reduced);
+        for (rxn_idx i = 0; i < order.size(); i++) {
+            new_idx[order[i]] = i;
+        }
+        m_r_reduced = order.size();
+        for (Cutset& cs : m_MCSs) {
+            cs.m_len = m_r_reduced;
+            for (rxn_idx& rxn : cs.m_active_rxns) {
+                rxn = new_idx[rxn];
+            }
+            sort(cs.m_active_rxns.begin(), cs.m_active_rxns.end());
+        }
+        if (m_compressed) {
+            vector<unsigned int> counts;
+            counts.reserve(order.size());
+            for (rxn_idx rxn : order) {
+                counts.push_back(m_compr_rxn_counts[rxn]);
+            }
+            m_compr_rxn_counts = counts;
+        }
+    }
+
+    /*
+     * alternative to reading the whole MCS file in the constructor and then
+     * calling get_cardinalities(). a reader thread parses the MCS file and
+     * appends the reduced MCSs to m_MCSs, while the worker threads start the
+     * recursion for the top-level MCS j as soon as MCSs 0..j have been read
+     * (the recursion for MCS j only requires the preceding MCSs). reading
+     * stops at the first MCS with cardinality > d0. requires a default
+     * constructed instance (set_compression() can be called beforehand for
+     * the compressed case).
+     */
+    void stream_cardinalities(const string& mcs_input_fname,
+                              unsigned int max_d, unsigned int num_threads = 1,
+                              bool use_cache = true) {
+        ifstream file(mcs_input_fname);
+        if (!file.is_open()) {
+            cout << "Error opening MCS file" << endl;
+            exit(EXIT_FAILURE);
+        }
+        *m_log << "Streaming MCS file...\n" << endl;
+        string line;
+        if (!getline(file, line)) {
+            cout << "Error: MCS file is empty" << endl;
+            exit(EXIT_FAILURE);
+        }
+        // all lines have the same length --> the file size gives an upper
+        // bound for the number of MCSs. reserving the space up front makes
+        // sure that m_MCSs is never reallocated while workers are reading it.
+        size_t num_cols = line.size();
+        file.seekg(0, ios::end);
+        size_t max_num_MCSs = file.tellg() / (num_cols + 1) + 1;
+        file.seekg(0, ios::beg);
+        m_MCSs.clear();
+        m_MCSs.reserve(max_num_MCSs);
+        if (!m_compressed) {
+            m_r = num_cols;
+        }
+        max_d = init_cd_table(max_d);
+        m_r_reduced = num_cols;
+        m_nMCS = 0;
+
+        // state shared between reader and workers
+        mutex mtx;
+        condition_variable cv;
+        size_t num_available = 0;
+        bool reading_done = false;
+
+        // reader thread
+        thread reader([&]() {
+            bool mcs1_done = false;
+            string line;
+            while (getline(file, line)) {
+                Cutset cs(line);
+                unsigned int card = cs.CARDINALITY();
+                if (card == 1 && !mcs1_done) {
+                    m_mcs1_rxns.push_back(cs.get_first_active_rxn());
+                    m_nMCS++;
+                    continue;
+                }
+                if (!mcs1_done) {
+                    finish_streamed_mcs1(num_cols);
+                    mcs1_done = true;
+                }
+                if (card > max_d) {
+                    // sorted by cardinality --> skip the rest of the file
                     break;
                 }
+                if (m_MCSs.size() == m_MCSs.capacity()) {
+                    cout << "Error: lines in MCS file differ in length" << endl;
+                    exit(EXIT_FAILURE);
+                }
+                m_nMCS++;
+                m_MCSs.push_back(
+                    (m_MCS_d1_present) ? cs.remove_rxns(m_mcs1_rxns) : cs);
+                {
+                    lock_guard<mutex> lock(mtx);
+                    num_available = m_MCSs.size();
+                }
+                cv.notify_all();
+            }
+            if (!mcs1_done) {
+                // file only contained MCSs with d=1
+                finish_streamed_mcs1(num_cols);
             }
-        }
-        // setup progress bar
-        progressbar prog_bar(last_MCS_to_consider);
-        size_t j;
-// initialize openMP for loop
-#pragma omp parallel for num_threads(num_threads)
-        for (size_t i = 0; i < last_MCS_to_consider; i++) {
-            // start with high cardinality MCSs first --> loop speeds up towards
-            // the end instead of slowing down --> nicer.
-            size_t j = last_MCS_to_consider - i - 1;
-#pragma omp task
             {
-                unsigned int mcs_card = m_MCSs[j].CARDINALITY();
-                // start recursion
-                GET_CARDINALITIES(j, m_MCSs[j], mcs_card, max_d, 1,
-                                  Cutset(m_r_reduced), use_cache);
-#pragma omp critical
-                { prog_bar.update(); }
+                lock_guard<mutex> lock(mtx);
+                reading_done = true;
+            }
+            cv.notify_all();
+        });
+
+        *m_log << "Starting recursion...\n" << endl;
+        size_t next_MCS = 0;
+        // the bitmaps of the states cover all columns (i.e. also the
+        // essential rxns that are removed by the reader). the MCSs aren't
+        // known yet --> counters for the whole table
+        vector<recursion_state> states;
+        states.reserve(num_threads);
+        for (unsigned int t = 0; t < num_threads; t++) {
+            states.emplace_back(num_cols,
+                                Accumulator(m_cd_table.size(), m_r, m_r));
+        }
+#pragma omp parallel num_threads(num_threads)
+        {
+            while (true) {
+                size_t j;
+#pragma omp critical(stream_next_MCS)
+                { j = next_MCS++; }
+                {
+                    // wait until MCS j has been read
+                    unique_lock<mutex> lock(mtx);
+                    cv.wait(lock, [&]() {
+                        return (num_available > j) || reading_done;
+                    });
+                    if (num_available <= j) {
+                        break;
+                    }
+                }
+                start_recursion(j, max_d, use_cache,
+                                states[omp_get_thread_num()]);
             }
         }
-        // add new lines after progress bar
-        cout << "\n\n" << endl;
+        reader.join();
+        for (recursion_state& state : states) {
+            state.counts.flush(m_cd_table);
+        }
+        file.close();
+        m_nMCS_reduced = m_MCSs.size();
+        *m_log << "Processed " << m_nMCS << " MCSs with d <= d0 ("
+             << m_num_mcs1 << " with d=1)\n"
+             << endl;
+    }
+
+    /*
+     * called by the reader thread in stream_cardinalities() once all MCSs
+     * with d=1 have been read. sets up the reduction and adds the MCS1 to the
+     * result table before the first MCS with d>1 is handed to the workers.
+     */
+    void finish_streamed_mcs1(size_t num_cols) {
+        m_num_mcs1 = m_mcs1_rxns.size();
+        if (m_num_mcs1 == 0) {
+            return;
+        }
+        m_MCS_d1_present = true;
+        // sort mcs1 rxns --> required for Cutset::remove_rxns
+        sort(m_mcs1_rxns.begin(), m_mcs1_rxns.end());
+        m_r_reduced = num_cols - m_num_mcs1;
+        if (m_compressed) {
+            reduce_compr_rxn_counts();
+        }
+        add_MCS1_to_table();
     }
 
     /*
-     * implement the recursive algorithm
+     * implement the recursive algorithm. besides the plus 1 rxns, MCSs that
+     * add exactly two rxns to Cs are folded into pairs of rxns that must not
+     * both be deleted (as long as the pairs are disjoint). they are resolved
+     * in closed form when adding to the result table instead of being
+     * recursed into. Cs holds the Cd deletions of the current cut set
+     * (sorted); the plus 1 rxns and pairs are in the state of the thread.
      */
-    void GET_CARDINALITIES(size_t index, const Cutset& Cs, unsigned int Cd,
+    void GET_CARDINALITIES(size_t index, const rxn_idx* Cs, unsigned int Cd,
                            unsigned int max_d, unsigned int depth,
-                           Cutset stored, bool use_cache) {
+                           bool use_cache, recursion_state& state) {
+        if (state.stop && state.stop->load(memory_order_relaxed)) {
+            return;
+        }
+        recursion_state::marker marker = state.mark();
         tuple<bool, bool, size_t> plus1_rxn_result;
-        vector<size_t> still_to_check;
-        still_to_check.reserve(index);
+        size_t* still_to_check = state.arena.alloc<size_t>(index);
+        size_t num_still_to_check = 0;
         size_t plus1_rxns = 0;
         unsigned int testCd;
-        // check for plus 1 rxns first
+        const rxn_idx* Cs_end = Cs + Cd;
+        // pairs of the parent with one rxn in Cs now --> the other rxn becomes
+        // a plus 1 rxn
+        for (const rxn_idx* rxn = Cs; rxn != Cs_end; rxn++) {
+            if (state.pair_of[*rxn] != NO_PAIR) {
+                rxn_idx partner = state.get_partner(*rxn);
+                state.drop_pair(state.pair_of[*rxn]);
+                state.add_stored(partner);
+            }
+        }
+        // check for plus 1 and plus 2 rxns first
         for (size_t i = 0; i < index; i++) {
-            if (!(m_MCSs[i] && stored)) {
-                plus1_rxn_result = Cs.find_plus1_rxn(m_MCSs[i]);
+            if (!state.hits_stored(m_MCSs[i])) {
+                plus1_rxn_result = find_plus1_rxn_in(Cs, Cs_end, m_MCSs[i]);
                 if (get<0>(plus1_rxn_result)) {
-                    stored.add_reaction(get<2>(plus1_rxn_result));
+                    state.add_stored(get<2>(plus1_rxn_result));
                 } else if (get<1>(plus1_rxn_result)) {
                     // check if the union of Cs and m_MCSs[i] would have too
                     // high cardinality --> don't check later
                     if (Cd + get<2>(plus1_rxn_result) > max_d) {
                         continue;
                     }
-                    still_to_check.push_back(i);
+                    // MCSs containing a pair end up in still_to_check and are
+                    // skipped there. no pairs in the gene-level model (the
+                    // columns of different pairs can share genes)
+                    if ((get<2>(plus1_rxn_result) == 2) && !state.col_genes) {
+                        rxn_pair rxns =
+                            find_plus2_rxns_in(Cs, Cs_end, m_MCSs[i]);
+                        if ((state.pair_of[rxns.first] == NO_PAIR) &&
+                            (state.pair_of[rxns.second] == NO_PAIR)) {
+                            state.add_pair(rxns);
+                            continue;
+                        }
+                    }
+                    still_to_check[num_still_to_check++] = i;
                 } else { // m_MCSs[i] is a subset
+                    state.rewind(marker);
                     return;
                 }
             }
         }
         // get number of plus 1 rxns
-        if (m_compressed) {
-            for (size_t rxn_id : stored.get_active_rxns()) {
+        if (state.col_genes) {
+            plus1_rxns = state.num_blocked_genes; // incl. essential genes
+        } else if (m_compressed) {
+            for (rxn_idx rxn_id : state.stored) {
                 plus1_rxns += m_compr_rxn_counts[rxn_id];
             }
             plus1_rxns += m_num_mcs1_uncompressed; // add MCS1 rxns
         } else {
-            plus1_rxns += stored.CARDINALITY() + m_num_mcs1;
-        }
-        // perform additional/deeper recursions if required
-        if (Cd < max_d) {
-            for (size_t j : still_to_check) {
-                if (!(m_MCSs[j] && stored)) {
-                    Cutset testCs = Cs | m_MCSs[j]; // looks inefficient to
-                    // create a new Cutset here in every iteration but is
-                    // actually not done due to compiler optimization
-                    testCd = testCs.CARDINALITY();
+            plus1_rxns += state.stored.size() + m_num_mcs1;
+        }
+        // perform additional/deeper recursions if required (and the max.
+        // inclusion-exclusion order isn't reached yet)
+        if ((Cd < max_d) && ((m_max_order == 0) || (depth < m_max_order))) {
+            for (size_t k = 0; k < num_still_to_check; k++) {
+                const Cutset& MCS = m_MCSs[still_to_check[k]];
+                if (!state.hits_stored(MCS) && !state.contains_pair(MCS)) {
+                    Arena::marker arena_marker = state.arena.mark();
+                    rxn_idx* testCs =
+                        state.arena.alloc<rxn_idx>(Cd + MCS.CARDINALITY());
+                    testCd = set_union_into(Cs, Cd, MCS.m_active_rxns.data(),
+                                            MCS.CARDINALITY(), testCs);
                     if (testCd <= max_d) {
                         // no need to check for testCd > Cd, since testCs must
                         // have at least 2 extra rxns
-                        GET_CARDINALITIES(j, testCs, testCd, max_d, depth + 1,
-                                          stored, use_cache);
+                        GET_CARDINALITIES(still_to_check[k], testCs, testCd,
+                                          max_d, depth + 1, use_cache, state);
                     }
+                    state.arena.release(arena_marker);
+                }
+            }
+        }
+        // closed form for the pairs (only the degrees that fit into d0 -->
+        // a pair requires at least two more deletions)
+        vector<long> pair_poly;
+        if (Cd + 2 <= max_d) {
+            vector<pair<unsigned int, unsigned int>> NCR_pairs;
+            for (size_t p = 0; p < state.pairs.size(); p++) {
+                if (!state.pair_active[p]) {
+                    continue;
                 }
+                const rxn_pair& rxns = state.pairs[p];
+                NCR_pairs.push_back(
+                    (m_compressed)
+                        ? make_pair(m_compr_rxn_counts[rxns.first],
+                                    m_compr_rxn_counts[rxns.second])
+                        : make_pair(1u, 1u));
             }
+            if (NCR_pairs.size() > 0) {
+                pair_poly = get_pair_correction(NCR_pairs, max_d - Cd);
+            }
+        }
+        if (state.hit_probs) {
+            state.hetero_sum += get_event_probability(Cs, Cs_end, depth, state);
         }
+        if (state.col_derivatives.size() > 0) {
+            add_event_derivatives(Cs, Cs_end, depth, plus1_rxns, state);
+        }
+        // no pairs --> no correction (i.e. 1)
+        size_t pair_poly_deg = (pair_poly.size() > 0) ? pair_poly.size() : 1;
         // get active rxns of current cutset
-        if (m_compressed) {
-            vector<rxn_idx> Cs_rxns = Cs.get_active_rxns();
+        if (state.col_genes) {
+            // genes that may still be deleted. a column without any can't be
+            // hit --> the event is impossible
+            Matrix<unsigned int> free_genes(Cd);
+            for (unsigned int i = 0; i < Cd; i++) {
+                for (unsigned int gene : m_col_genes[Cs[i]]) {
+                    if (!state.gene_refs[gene]) {
+                        free_genes[i].push_back(gene);
+                    }
+                }
+                if (free_genes[i].size() == 0) {
+                    state.rewind(marker);
+                    return;
+                }
+            }
+            map<size_t, wide_count> table = resolve_gene_level_cutset(
+                free_genes, m_cd_table.size(), depth);
+            for (const auto& elem : table) {
+                state.counts.add(elem.first - 1, plus1_rxns, elem.second);
+                if (m_mcs_contributions.size() > 0) {
+                    state.contribution += (long double)elem.second *
+                                          m_pow_p[elem.first] *
+                                          m_pow_q[plus1_rxns];
+                }
+                if (depth == m_max_order) {
+                    state.top_order_counts.add(elem.first - 1, plus1_rxns,
+                                               elem.second);
+                }
+            }
+        } else if (m_compressed) {
             vector<unsigned int> NCRs;
             // get NCRs to resolved to uncompressed case later
-            NCRs.reserve(Cs_rxns.size());
-            for (auto rxn_id : Cs_rxns) {
-                NCRs.push_back(m_compr_rxn_counts[rxn_id]);
+            NCRs.reserve(Cd);
+            for (const rxn_idx* rxn_id = Cs; rxn_id != Cs_end; rxn_id++) {
+                NCRs.push_back(m_compr_rxn_counts[*rxn_id]);
             }
             sort(NCRs.begin(), NCRs.end());
             // resolve compressed cut set
-            map<size_t, int> table =
+            map<size_t, wide_count> table =
                 resolve_compressed_cutset(NCRs, max_d, depth, use_cache);
-// single threaded now while adding to result table
-#pragma omp critical
-            {
-                for (const auto& elem : table) {
-                    size_t Mj = elem.first;
-                    int count = elem.second;
-                    m_cd_table[Mj - 1][plus1_rxns] += count;
+            for (const auto& elem : table) {
+                size_t Mj = elem.first;
+                wide_count count = elem.second;
+                for (size_t k = 0; (k < pair_poly_deg) && (Mj + k <= max_d);
+                     k++) {
+                    wide_count value =
+                        (k > 0) ? checked_mul(count, pair_poly[k],
+                                              "GET_CARDINALITIES")
+                                : count;
+                    state.counts.add(Mj + k - 1, plus1_rxns, value);
+                    if (m_mcs_contributions.size() > 0) {
+                        state.contribution += (long double)value *
+                                              m_pow_p[Mj + k] *
+                                              m_pow_q[plus1_rxns];
+                    }
+                    if (depth == m_max_order) {
+                        state.top_order_counts.add(Mj + k - 1, plus1_rxns,
+                                                   value);
+                    }
                 }
             }
         } else {
             int sign = (depth % 2) ? 1 : -1;
-#pragma omp critical
-            { m_cd_table[Cd - 1][plus1_rxns] += sign; }
+            for (size_t k = 0; k < pair_poly_deg; k++) {
+                long value = sign * ((k > 0) ? pair_poly[k] : 1);
+                state.counts.add(Cd + k - 1, plus1_rxns, value);
+                if (m_mcs_contributions.size() > 0) {
+                    state.contribution +=
+                        value * m_pow_p[Cd + k] * m_pow_q[plus1_rxns];
+                }
+                if (depth == m_max_order) {
+                    state.top_order_counts.add(Cd + k - 1, plus1_rxns, value);
+                }
+            }
+        }
+        state.rewind(marker);
+    }
+
+    /*
+     * upper bound for the fraction of lethal deletion sets of size d that
+     * were not counted because their subtrees are unfinished
+     */
+    double score_unfinished(unsigned int d) const {
+        double score = 0;
+        for (const auto& elem : m_unfinished) {
+            if (elem.first.first <= d) {
+                score += (double)elem.second *
+                         SCORE(m_r, elem.first.second, elem.first.first, d);
+            }
+        }
+        return score;
+    }
+
+    /*
+     * lower bound for F(d): the actual F(d) for d <= d0 and for d > d0 the
+     * larger one of F(d0) (i.e. prev_score) and F1(d) (see print_results)
+     */
+    double get_lower_score(unsigned int d, double prev_score) const {
+        if (d <= m_max_d) {
+            double score = get<0>(score_cd_table2(d));
+            // a truncated inclusion-exclusion can fall below F1(d)
+            return (m_max_order > 0) ? max(score, get_f1(d)) : score;
+        }
+        return max(prev_score, get_f1(d));
+    }
+
+    /*
+     * difference between the upper bound for F(d) and score (i.e. the lower
+     * bound). for d <= dm, F(d) is exact unless there are unfinished
+     * subtrees or the inclusion-exclusion was truncated.
+     */
+    double get_score_gap(unsigned int d, double score, unsigned int dm) const {
+        if (d > dm) {
+            return 1 - score;
+        }
+        if (m_unfinished.size() > 0) {
+            return min(1 - score, score_unfinished(d));
+        }
+        if (m_cd_table_upper.size() > 0) {
+            if (d > m_max_d) {
+                return 1 - score;
+            }
+            double upper = get<0>(score_cd_table2(d, m_cd_table_upper));
+            return max(0.0, min(1.0, upper) - score);
+        }
+        return 0;
+    }
+
+    /*
+     * lower and upper bound of the PoF (as in print_results)
+     */
+    tuple<double, double> get_PoF_bounds(double p, unsigned int dm) const {
+        double score = 0, lower = 0, error = 0;
+        for (size_t d = 1; d <= m_r; d++) {
+            score = get_lower_score(d, score);
+            double weight = binom_dist_weight(m_r, d, p);
+            if (weight < WEIGHT_LIMIT) {
+                break;
+            }
+            lower += score * weight;
+            error += weight * get_score_gap(d, score, dm);
         }
+        return make_tuple(lower, lower + error);
     }
 
     /*
      * evaluate result table to give f(d, m0)
      */
     double score_cd_table(unsigned int d) const {
-        long count;
+        wide_count count;
         double score = 0;
         for (size_t Mj = 0; Mj < m_cd_table.size(); Mj++) {
             for (size_t a = 0; a < m_cd_table[Mj].size(); a++) {
                 count = m_cd_table[Mj][a];
                 if (count != 0) {
                     // the actual Mj is larger (0 indexing in 2d-vector)
-                    score += count * SCORE(m_r, a, Mj + 1, d);
+                    score += (double)count * SCORE(m_r, a, Mj + 1, d);
                 }
             }
         }
@@ -386,14 +2732,18 @@ class PoF_calculator {
      * reactions
      */
     double get_f1(unsigned int d) const {
-        long count;
+        return get_f1(d, m_cd_table);
+    }
+
+    double get_f1(unsigned int d, const Matrix<wide_count>& cd_table) const {
+        wide_count count;
         double f1 = 0;
         // only iterate over the first row in table --> all MCSs with d=1
-        for (size_t a = 0; a < m_cd_table[0].size(); a++) {
-            count = m_cd_table[0][a];
+        for (size_t a = 0; a < cd_table[0].size(); a++) {
+            count = cd_table[0][a];
             if (count != 0) {
                 // the actual Mj 1
-                f1 += count * SCORE(m_r, a, 1, d);
+                f1 += (double)count * SCORE(m_r, a, 1, d);
             }
         }
         return f1;
@@ -403,16 +2753,23 @@ class PoF_calculator {
      * evaluate result table to give f(d, m0)
      */
     tuple<double, double> score_cd_table2(unsigned int d) const {
-        long count;
-        double f1 = get_f1(d);
+        return score_cd_table2(d, m_cd_table);
+    }
+
+    tuple<double, double>
+    score_cd_table2(unsigned int d, const Matrix<wide_count>& cd_table) const {
+        wide_count count;
+        double f1 = get_f1(d, cd_table);
         double score = f1;
-        if (m_cd_table.size() > 1) {
-            for (size_t Mj = 1; Mj < m_cd_table.size(); Mj++) {
-                for (size_t a = 0; a < m_cd_table[Mj].size(); a++) {
-                    count = m_cd_table[Mj][a];
+        if (m_lethal_counts.size() > 0) {
+            score += score_lethal_counts(d);
+        } else if (cd_table.size() > 1) {
+            for (size_t Mj = 1; Mj < cd_table.size(); Mj++) {
+                for (size_t a = 0; a < cd_table[Mj].size(); a++) {
+                    count = cd_table[Mj][a];
                     if (count != 0) {
                         // the actual Mj is larger (0 indexing in 2d-vector)
-                        score += count * SCORE(m_r, a, Mj + 1, d);
+                        score += (double)count * SCORE(m_r, a, Mj + 1, d);
                     }
                 }
             }
@@ -420,6 +2777,275 @@ class PoF_calculator {
         return make_tuple(score, f1);
     }
 
+    /*
+     * probability that d random deletions hit no essential rxn and contain a
+     * lethal set of the ZDD engine: k of the deletions in the columns of the
+     * ZDD and d - k in the remaining rxns (hypergeometric, in log space to
+     * handle the large counts)
+     */
+    double score_lethal_counts(unsigned int d) const {
+        size_t num_mcs1 = (m_compressed) ? m_num_mcs1_uncompressed : m_num_mcs1;
+        size_t s = m_zdd_num_rxns, o = m_r - num_mcs1 - s;
+        long double log_all = log_binom(m_r, d), score = 0;
+        for (size_t k = 1; (k < m_lethal_counts.size()) && (k <= d); k++) {
+            if ((m_lethal_counts[k] <= 0) || (d - k > o)) {
+                continue;
+            }
+            score += expl(logl(m_lethal_counts[k]) + log_binom(o, d - k) -
+                          log_all);
+        }
+        return score;
+    }
+
+    /*
+     * probability that d random deletions hit no essential rxn and exactly k
+     * of the num_rxns rxns in the columns of the MCSs (hypergeometric)
+     */
+    double get_stratum_weight(unsigned int d, size_t k, size_t num_rxns) const {
+        size_t num_mcs1 = (m_compressed) ? m_num_mcs1_uncompressed : m_num_mcs1;
+        size_t o = m_r - num_mcs1 - num_rxns;
+        if ((k > d) || (k > num_rxns) || (d - k > o)) {
+            return 0;
+        }
+        return expl(log_binom(num_rxns, k) + log_binom(o, d - k) -
+                    log_binom(m_r, d));
+    }
+
+    /*
+     * whether F(d) is known exactly from the recursion (or the other engines)
+     * --> the Monte Carlo estimate is only needed for larger d
+     */
+    bool is_exact_score(unsigned int d) const {
+        return (m_cd_table.size() > 0) && (d <= m_max_d) &&
+               (m_unfinished.size() == 0) && (m_cd_table_upper.size() == 0);
+    }
+
+    /*
+     * Monte Carlo estimate of F(d) and its variance: the essential rxns are
+     * accounted for exactly and the fraction of lethal sets of k deletions in
+     * the columns of the MCSs is estimated from the samples of that stratum.
+     */
+    tuple<double, double> get_sampled_score(unsigned int d) const {
+        size_t num_mcs1 = (m_compressed) ? m_num_mcs1_uncompressed : m_num_mcs1;
+        size_t num_rxns = m_sampled_rxns;
+        double score = -expm1l(log_binom(m_r - num_mcs1, d) - log_binom(m_r, d));
+        double var = 0;
+        for (size_t k = 1; (k < m_lethal_samples.size()) && (k <= d); k++) {
+            double weight = get_stratum_weight(d, k, num_rxns);
+            double q = m_lethal_samples[k] / (double)m_num_samples;
+            score += weight * q;
+            var += weight * weight * q * (1 - q) / m_num_samples;
+        }
+        return make_tuple(score, var);
+    }
+
+    /*
+     * print the Monte Carlo estimates of F(d) (for the d not covered exactly)
+     * and of the PoF with 95% confidence intervals. the strata are shared by
+     * all d --> the variance of the PoF is summed over the strata and not
+     * over d. for d > dm only the known MCSs are taken into account.
+     */
+    void print_sampling_results(double p, unsigned int dm) const {
+        cout << "\nMonte Carlo estimate (" << m_num_samples
+             << " samples per number of deletions, seed " << m_seed
+             << "):\n"
+             << endl;
+        Table table{{"d", "weight", "F(d)", "95% CI low", "95% CI high",
+                     "weighted F(d)"},
+                    {5, 20, 20, 20, 20, 20},
+                    {"%.5g", "%.10g", "%.10g", "%.10g", "%.10g", "%.10g"}};
+        table.print_header();
+        size_t num_rxns = m_sampled_rxns;
+        // coefficient of the estimated fraction of every stratum in the PoF
+        vector<double> coeffs(m_lethal_samples.size(), 0);
+        double PoF = 0;
+        for (size_t d = 1; d <= m_r; d++) {
+            double weight = binom_dist_weight(m_r, d, p);
+            if (weight < WEIGHT_LIMIT) {
+                break;
+            }
+            double score, var = 0;
+            if (is_exact_score(d)) {
+                score = get<0>(score_cd_table2(d));
+            } else {
+                tie(score, var) = get_sampled_score(d);
+                for (size_t k = 1; (k < coeffs.size()) && (k <= d); k++) {
+                    coeffs[k] += weight * get_stratum_weight(d, k, num_rxns);
+                }
+            }
+            PoF += weight * score;
+            double half_width = CI_Z * sqrt(var);
+            vector<double> numbers{(double)d,
+                                   weight,
+                                   score,
+                                   max(0.0, score - half_width),
+                                   min(1.0, score + half_width),
+                                   weight * score};
+            table.print_row(numbers);
+        }
+        double var = 0;
+        for (size_t k = 1; k < coeffs.size(); k++) {
+            double q = m_lethal_samples[k] / (double)m_num_samples;
+            var += coeffs[k] * coeffs[k] * q * (1 - q) / m_num_samples;
+        }
+        double half_width = CI_Z * sqrt(var);
+        cout << endl;
+        printf("Sampled PoF(d0=r)\t= %.15e\t\t--> estimate\n", PoF);
+        printf("95%% CI of the estimate\t= [%.15e, %.15e]\n",
+               max(0.0, PoF - half_width), PoF + half_width);
+        if (dm < get_max_weighted_d(p)) {
+            printf("(for d > dm=%d only the known MCSs are considered)\n", dm);
+        }
+        cout << string(22, '-') << endl;
+    }
+
+    /*
+     * name of an original column of the MCS file (its index if the names are
+     * not known)
+     */
+    string get_column_name(rxn_idx col) const {
+        return (m_column_names.size() > 0) ? m_column_names[col]
+                                           : to_string(col);
+    }
+
+    /*
+     * print the MCSs with the largest contributions to the PoF and the rxns
+     * with the largest derivatives of the PoF. the contribution of an MCS is
+     * the probability that it is the first one hit (these events partition
+     * the PoF, but depend on the order of the MCSs). the derivative by the
+     * probability p_i of a rxn i in column c is dPoF/dh_c * dh_c/dp_i with
+     * dh_c/dp_i = (1 - p)^(n_c - 1), for an essential rxn it is
+     * (1 - PoF) / (1 - p) (PoF = 1 - (1 - p)^n * (1 - lethal)).
+     */
+    void print_attribution() const {
+        double p = m_attribution_p;
+        size_t num_cols = m_r_reduced + m_mcs1_rxns.size();
+        vector<pair<long double, string>> mcs_contributions;
+        long double PoF = 0;
+        // essential columns: (Mj=1, a) for the a-th essential rxn
+        size_t a = 0;
+        for (rxn_idx col : m_mcs1_rxns) {
+            unsigned int n =
+                (m_column_rxn_counts.size() > 0) ? m_column_rxn_counts[col] : 1;
+            long double contribution = 0;
+            for (unsigned int i = 0; i < n; i++, a++) {
+                contribution += p * powl(1 - p, a);
+            }
+            mcs_contributions.push_back(
+                make_pair(contribution, get_column_name(col)));
+            PoF += contribution;
+        }
+        // the other MCSs (mapped back to the original columns)
+        vector<rxn_idx> original_cols;
+        for (rxn_idx col = 0, e = 0; col < num_cols; col++) {
+            if ((e < m_mcs1_rxns.size()) && (m_mcs1_rxns[e] == col)) {
+                e++;
+            } else {
+                original_cols.push_back(col);
+            }
+        }
+        for (size_t j = 0; j < m_mcs_contributions.size(); j++) {
+            string name;
+            for (rxn_idx rxn : m_MCSs[j].m_active_rxns) {
+                name += ((name.size() > 0) ? " " : "") +
+                        get_column_name(original_cols[rxn]);
+            }
+            mcs_contributions.push_back(
+                make_pair(m_mcs_contributions[j], name));
+            PoF += m_mcs_contributions[j];
+        }
+        auto larger = [](const pair<long double, string>& x,
+                         const pair<long double, string>& y) {
+            return x.first > y.first;
+        };
+        size_t num_mcs = min(m_num_attributions, mcs_contributions.size());
+        partial_sort(mcs_contributions.begin(),
+                     mcs_contributions.begin() + num_mcs,
+                     mcs_contributions.end(), larger);
+        printf("\nMCSs with the largest contributions to the PoF (sum of "
+               "all contributions: %.15e; the first MCS hit depends on the "
+               "order of the MCSs):\n\n",
+               (double)PoF);
+        printf("%6s  %22s  %10s  %s\n", "rank", "P(first MCS hit)", "share",
+               "MCS");
+        for (size_t i = 0; i < num_mcs; i++) {
+            printf("%6zu  %22.15e  %10.4g  %s\n", i + 1,
+                   (double)mcs_contributions[i].first,
+                   (double)(mcs_contributions[i].first / PoF),
+                   mcs_contributions[i].second.c_str());
+        }
+        // derivatives per uncompressed rxn of every column
+        size_t num_mcs1 = (m_compressed) ? m_num_mcs1_uncompressed : m_num_mcs1;
+        long double event_PoF = 1 - powl(1 - p, num_mcs1) + m_event_sum;
+        vector<pair<long double, string>> rxns;
+        vector<unsigned int> rxn_counts;
+        for (rxn_idx col : m_mcs1_rxns) {
+            rxns.push_back(
+                make_pair((1 - event_PoF) / (1 - p), get_column_name(col)));
+            rxn_counts.push_back(
+                (m_column_rxn_counts.size() > 0) ? m_column_rxn_counts[col]
+                                                 : 1);
+        }
+        for (size_t col = 0; col < m_col_derivatives.size(); col++) {
+            if (m_col_derivatives[col] == 0) {
+                continue;
+            }
+            unsigned int n = (m_compressed) ? m_compr_rxn_counts[col] : 1;
+            rxns.push_back(make_pair(m_col_derivatives[col] *
+                                         powl(1 - p, n - 1),
+                                     get_column_name(original_cols[col])));
+            rxn_counts.push_back(n);
+        }
+        // sort indices to keep the numbers of rxns with their columns
+        vector<size_t> order(rxns.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        size_t num_rxns = min(m_num_attributions, rxns.size());
+        partial_sort(order.begin(), order.begin() + num_rxns, order.end(),
+                     [&rxns](size_t x, size_t y) {
+                         return rxns[x].first > rxns[y].first;
+                     });
+        printf("\nReactions with the largest derivatives dPoF/dp of the PoF "
+               "by their failure probability (%s):\n\n",
+               (m_max_d < m_r) ? "truncated at d0, exact for d0=r" : "exact");
+        printf("%6s  %22s  %10s  %s\n", "rank", "dPoF/dp per reaction",
+               "reactions", "column");
+        for (size_t i = 0; i < num_rxns; i++) {
+            printf("%6zu  %22.15e  %10u  %s\n", i + 1,
+                   (double)rxns[order[i]].first, rxn_counts[order[i]],
+                   rxns[order[i]].second.c_str());
+        }
+        cout << string(22, '-') << endl;
+    }
+
+    /*
+     * log of binomial coefficient
+     */
+    static long double log_binom(size_t n, size_t k) {
+        return lgammal(n + 1.0L) - lgammal(k + 1.0L) - lgammal(n - k + 1.0L);
+    }
+
+    /*
+     * final PoF for the counts of the ZDD engine: either an essential rxn is
+     * deleted or none is and the deletions in the ZDD columns are lethal. the
+     * latter only includes lethal sets with up to d0 deletions --> lower
+     * bound unless d0 covers all rxns of the ZDD.
+     */
+    double get_zdd_PoF(double p) const {
+        size_t num_mcs1 = (m_compressed) ? m_num_mcs1_uncompressed : m_num_mcs1;
+        long double survive_mcs1 = powl(1 - (long double)p, num_mcs1),
+                    lethal = 0;
+        for (size_t k = 1; k < m_lethal_counts.size(); k++) {
+            if (m_lethal_counts[k] <= 0) {
+                continue;
+            }
+            lethal += expl(logl(m_lethal_counts[k]) + k * logl(p) +
+                           (m_zdd_num_rxns - k) * log1pl(-p));
+        }
+        return 1 - survive_mcs1 + survive_mcs1 * lethal;
+    }
+
     /*
      * scoring function (eq. 3 in paper) in a form that avoids binomial
      * coefficients
@@ -531,7 +3157,7 @@ class PoF_calculator {
      * bound for every d > d0 the larger one of F(d0) or F1(d) is selected.
      */
     void print_results(double p, unsigned int dm = 0, bool print_poly = false) {
-        double score, f1, weight, weighted_score,
+        double score, weight, weighted_score,
             acc_weighted_score = 0, found_CS, possible_CS, error = 0;
         // initialize table to print results
         Table table{
@@ -542,18 +3168,9 @@ class PoF_calculator {
         table.print_header();
 
         // get score for each d and print the corresponding numbers
+        score = 0;
         for (size_t d = 1; d <= m_r; d++) {
-            if (d <= m_max_d) {
-                // update score while d < d0
-                tie(score, f1) = score_cd_table2(d);
-            } else {
-                // only update f1, but keep old score (i.e. f(d0))
-                f1 = get_f1(d);
-                // use f1 instead of f(d0) as soon as it's larger
-                if (f1 > score) {
-                    score = f1;
-                }
-            }
+            score = get_lower_score(d, score);
             weight = binom_dist_weight(m_r, d, p);
             if (weight < WEIGHT_LIMIT) {
                 printf("\nFor d>%d the weight is smaller than the threshold "
@@ -568,6 +3185,8 @@ class PoF_calculator {
             found_CS = score * possible_CS;
             if (d > dm) {
                 error += weight - weighted_score;
+            } else {
+                error += weight * get_score_gap(d, score, dm);
             }
             vector<double> numbers{
                 d,        weight,     score, weighted_score, acc_weighted_score,
@@ -580,11 +3199,21 @@ class PoF_calculator {
                acc_weighted_score);
         double final_PoF;
         string polynomial;
-        tie(final_PoF, polynomial) =
-            get_final_PoF(convert_table(m_cd_table), p, print_poly);
-        printf("Polynomial PoF(d0=r)\t= %.15e\t\t--> best guess, but might "
-               "overshoot\n",
-               final_PoF);
+        if (m_lethal_counts.size() > 0) {
+            // only the lethal sets with up to d0 deletions are counted
+            final_PoF = get_zdd_PoF(p);
+            polynomial = "not available for ZDD engine";
+            printf("ZDD PoF(d0=%u)\t\t= %.15e\t\t--> %s\n", m_max_d,
+                   final_PoF,
+                   (m_max_d < m_zdd_num_rxns) ? "lower bound (truncated at d0)"
+                                              : "exact");
+        } else {
+            tie(final_PoF, polynomial) =
+                get_final_PoF(convert_table(m_cd_table), p, print_poly);
+            printf("Polynomial PoF(d0=r)\t= %.15e\t\t--> best guess, but "
+                   "might overshoot\n",
+                   final_PoF);
+        }
         printf("It. PoF(d0=r) + error\t= %.15e\t\t--> upper bound\n",
                acc_weighted_score + error);
         cout << string(22, '-') << endl;
@@ -592,6 +3221,25 @@ class PoF_calculator {
         if (print_poly) {
             cout << "Polynomial: " << polynomial << endl;
         }
+        if (m_num_samples > 0) {
+            print_sampling_results(p, dm);
+        }
+        if (m_heterogeneous) {
+            // the events of the recursion assume no essential rxn deleted
+            long double PoF =
+                1 - m_survival_mcs1 + m_survival_mcs1 * m_hetero_sum;
+            printf("\nPoF for the rxn probabilities\t= %.15e\t\t--> %s\n",
+                   (double)PoF,
+                   (m_max_d < m_r) ? "truncated at d0 (exact for d0=r)"
+                                   : "exact");
+            cout << string(22, '-') << endl;
+        }
+        if (m_num_attributions > 0) {
+            print_attribution();
+        }
+        if (m_prefix_tables.size() > 0) {
+            print_prefix_results(p, dm);
+        }
     }
 };
 
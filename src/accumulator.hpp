@@ -0,0 +1,108 @@
+#ifndef ACCUMULATOR_HPP
+#define ACCUMULATOR_HPP
+
+#include "types.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+/*
+ * thread-local accumulator for the entries of the result table. only the
+ * entries a thread can reach get a 32-bit counter: the first rows (union
+ * cardinalities) and the columns from col_offset on (plus 1 rxns), at most
+ * MAX_DENSE_CELLS of them. most increments are small --> they go to these
+ * counters, which keeps the block compact and needs no synchronization. a
+ * counter that would overflow, an increment that doesn't fit into 32 bits
+ * and any entry outside of the block are kept in a sparse map of 128-bit
+ * totals. flush() adds everything to the shared result table (once the
+ * thread is done or after every top-level subtree). only the entries touched
+ * since the last flush are visited.
+ */
+class Accumulator {
+  public:
+    static const size_t MAX_DENSE_CELLS = 1 << 20;
+
+    /*
+     * rows x cols counters for the entries (row, col_offset + col) of a
+     * table with table_cols columns
+     */
+    Accumulator(size_t rows = 0, size_t cols = 0, size_t table_cols = 0,
+                size_t col_offset = 0)
+        : m_rows((cols > 0) ? min(rows, MAX_DENSE_CELLS / cols) : 0),
+          m_cols(cols), m_table_cols(max(table_cols, col_offset + cols)),
+          m_col_offset(col_offset), m_small(m_rows * m_cols, 0),
+          m_touched(m_rows * m_cols, 0) {
+    }
+
+    void add(size_t row, size_t col, wide_count value) {
+        if ((row >= m_rows) || (col < m_col_offset) ||
+            (col - m_col_offset >= m_cols)) {
+            m_wide[row * m_table_cols + col] += value;
+            return;
+        }
+        size_t i = row * m_cols + (col - m_col_offset);
+        if (!m_touched[i]) {
+            m_touched[i] = 1;
+            m_dirty.push_back(i);
+        }
+        int32_t sum;
+        if ((value >= numeric_limits<int32_t>::min()) &&
+            (value <= numeric_limits<int32_t>::max()) &&
+            !__builtin_add_overflow(m_small[i], (int32_t)value, &sum)) {
+            m_small[i] = sum;
+        } else {
+            m_wide[(i / m_cols) * m_table_cols + (i % m_cols) +
+                   m_col_offset] += m_small[i] + value;
+            m_small[i] = 0;
+        }
+    }
+
+    /*
+     * add the counts to table and reset them
+     */
+    void flush(Matrix<wide_count>& table) {
+        for (size_t i : m_dirty) {
+            table[i / m_cols][i % m_cols + m_col_offset] += m_small[i];
+        }
+        for (const auto& elem : m_wide) {
+            table[elem.first / m_table_cols][elem.first % m_table_cols] +=
+                elem.second;
+        }
+        clear();
+    }
+
+    /*
+     * discard the counts
+     */
+    void clear() {
+        for (size_t i : m_dirty) {
+            m_small[i] = 0;
+            m_touched[i] = 0;
+        }
+        m_dirty.clear();
+        m_wide.clear();
+    }
+
+    /*
+     * bytes of the counters (approx. for the sparse ones)
+     */
+    size_t get_memory() const {
+        return m_small.size() * (sizeof(int32_t) + 1) +
+               m_dirty.capacity() * sizeof(size_t) +
+               m_wide.size() * (sizeof(size_t) + sizeof(wide_count) +
+                                2 * sizeof(void*));
+    }
+
+  private:
+    size_t m_rows, m_cols, m_table_cols, m_col_offset;
+    vector<int32_t> m_small;
+    vector<char> m_touched;
+    vector<size_t> m_dirty;
+    // entry (row * m_table_cols + col) --> count
+    unordered_map<size_t, wide_count> m_wide;
+};
+
+#endif /* ACCUMULATOR_HPP */
@@ -0,0 +1,84 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+using namespace std;
+
+/*
+ * bump allocator for the temporaries of the recursion (every thread needs its
+ * own instance). memory is handed out from large blocks that are kept for the
+ * lifetime of the arena. allocations are never freed individually; instead,
+ * mark() and release() rewind the arena to an earlier state (freeing
+ * everything allocated since the mark at once), which fits the stack-like
+ * life time of the temporaries in the recursion. reset() frees everything.
+ */
+class Arena {
+  public:
+    struct marker {
+        size_t block, offset;
+    };
+
+    Arena(size_t block_size = 1 << 20) : m_block_size(block_size) {
+    }
+
+    /*
+     * uninitialized memory for n elements of (trivially constructible) T
+     */
+    template <typename T> T* alloc(size_t n) {
+        size_t bytes = n * sizeof(T);
+        size_t offset = align(m_offset, alignof(T));
+        while ((m_block >= m_blocks.size()) ||
+               (offset + bytes > m_sizes[m_block])) {
+            if (m_block < m_blocks.size()) {
+                // current block is full --> continue in the next one
+                m_block++;
+                offset = 0;
+                continue;
+            }
+            size_t size = max(m_block_size, bytes);
+            m_blocks.push_back(unique_ptr<char[]>(new char[size]));
+            m_sizes.push_back(size);
+            offset = 0;
+        }
+        m_offset = offset + bytes;
+        return reinterpret_cast<T*>(m_blocks[m_block].get() + offset);
+    }
+
+    marker mark() const {
+        return marker{m_block, m_offset};
+    }
+
+    void release(const marker& m) {
+        m_block = m.block;
+        m_offset = m.offset;
+    }
+
+    void reset() {
+        m_block = 0;
+        m_offset = 0;
+    }
+
+    /*
+     * bytes of all blocks
+     */
+    size_t get_memory() const {
+        size_t bytes = 0;
+        for (size_t size : m_sizes) {
+            bytes += size;
+        }
+        return bytes;
+    }
+
+  private:
+    vector<unique_ptr<char[]>> m_blocks;
+    vector<size_t> m_sizes;
+    size_t m_block_size, m_block = 0, m_offset = 0;
+
+    static size_t align(size_t offset, size_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+};
+
+#endif /* ARENA_HPP */
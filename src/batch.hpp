@@ -0,0 +1,287 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "PoF_calculator.hpp"
+#include "table.hpp"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <omp.h>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+/*
+ * batch mode: many networks (jobs) share one pool of threads. the top-level
+ * subtrees of all jobs are put into one list (job by job, the most expensive
+ * subtrees of a job first) that the threads work off dynamically --> a thread
+ * that is done with a job continues with the next one while the others finish
+ * the tail of the previous one instead of waiting. every thread keeps one
+ * recursion state at a time and flushes it into the result table of its job
+ * when it moves on to another job.
+ *
+ * every non-empty line of the manifest describes a job as key=value pairs
+ * ('#' starts a comment):
+ *   mcs=FILE [comp=FILE] [names=FILE] [r=N] [d0=N] [dm=N] [p=P1,P2,...]
+ *   [out=FILE]
+ * (d0, dm and p default to the values given on the command line, out to the
+ * MCS file with the suffix '.pof'). the full results of every job and p are
+ * written to its output file, a summary with the memory of every job to
+ * stdout.
+ */
+
+struct batch_job {
+    string mcs_fname, compr_fname, names_fname, out_fname;
+    size_t r = 0;
+    unsigned int max_d = 0, dm = 0;
+    vector<double> ps;
+    PoF_calculator calc;
+    // number of top-level subtrees, bytes of the MCSs and the result table,
+    // max. number of recursion states at the same time and their max. size
+    size_t num_top_level = 0, mcs_bytes = 0, table_bytes = 0;
+    size_t num_states = 0, peak_states = 0, state_bytes = 0;
+    // time spent in the recursion (summed over the threads)
+    double thread_seconds = 0;
+};
+
+/*
+ * parse the jobs of a manifest. stops the program for invalid lines (as
+ * for the other input files).
+ */
+inline vector<unique_ptr<batch_job>>
+read_batch_manifest(const string& fname, unsigned int max_d, unsigned int dm,
+                    double p) {
+    ifstream file(fname);
+    if (!file.is_open()) {
+        cout << "Error opening batch manifest" << endl;
+        exit(EXIT_FAILURE);
+    }
+    vector<unique_ptr<batch_job>> jobs;
+    string line, token;
+    size_t line_num = 0;
+    while (getline(file, line)) {
+        line_num++;
+        line = line.substr(0, line.find('#'));
+        istringstream tokens(line);
+        unique_ptr<batch_job> job(new batch_job);
+        job->max_d = max_d;
+        job->dm = dm;
+        bool empty = true;
+        while (tokens >> token) {
+            empty = false;
+            size_t eq = token.find('=');
+            string key = token.substr(0, eq);
+            string val = (eq == string::npos) ? "" : token.substr(eq + 1);
+            if (key == "mcs") {
+                job->mcs_fname = val;
+            } else if (key == "comp") {
+                job->compr_fname = val;
+            } else if (key == "names") {
+                job->names_fname = val;
+            } else if (key == "out") {
+                job->out_fname = val;
+            } else if (key == "r") {
+                job->r = strtoull(val.c_str(), NULL, 10);
+            } else if (key == "d0") {
+                job->max_d = atoi(val.c_str());
+            } else if (key == "dm") {
+                job->dm = atoi(val.c_str());
+            } else if (key == "p") {
+                istringstream ps(val);
+                string prob;
+                while (getline(ps, prob, ',')) {
+                    job->ps.push_back(atof(prob.c_str()));
+                    if ((job->ps.back() <= 0) || (job->ps.back() >= 1)) {
+                        cout << "Error in line " << line_num
+                             << " of the batch manifest: p should be "
+                                "between 0 and 1"
+                             << endl;
+                        exit(EXIT_FAILURE);
+                    }
+                }
+            } else {
+                cout << "Error in line " << line_num
+                     << " of the batch manifest: unknown key '" << key << "'"
+                     << endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (empty) {
+            continue;
+        }
+        if (job->mcs_fname.size() == 0) {
+            cout << "Error in line " << line_num
+                 << " of the batch manifest: no MCS file" << endl;
+            exit(EXIT_FAILURE);
+        }
+        if ((job->names_fname.size() > 0) && (job->compr_fname.size() > 0)) {
+            cout << "Error in line " << line_num
+                 << " of the batch manifest: comp can't be combined with "
+                    "names"
+                 << endl;
+            exit(EXIT_FAILURE);
+        }
+        if (job->ps.size() == 0) {
+            job->ps.push_back(p);
+        }
+        if (job->out_fname.size() == 0) {
+            job->out_fname = job->mcs_fname + ".pof";
+        }
+        jobs.push_back(move(job));
+    }
+    return jobs;
+}
+
+/*
+ * write the results of a job for all of its p to its output file (the
+ * results are printed by print_results --> stdout is redirected to the file
+ * in the meantime)
+ */
+inline void write_batch_results(batch_job& job) {
+    FILE* out = fopen(job.out_fname.c_str(), "w");
+    if (!out) {
+        cout << "Error opening output file " << job.out_fname << endl;
+        return;
+    }
+    cout.flush();
+    fflush(stdout);
+    int stdout_fd = dup(STDOUT_FILENO);
+    dup2(fileno(out), STDOUT_FILENO);
+    for (double p : job.ps) {
+        cout << "PoF of " << job.mcs_fname << " for p = " << p
+             << ", d0 = " << job.calc.m_max_d << ", dm = " << job.dm << "\n"
+             << endl;
+        job.calc.print_results(p, job.dm);
+        cout << endl;
+    }
+    cout.flush();
+    fflush(stdout);
+    dup2(stdout_fd, STDOUT_FILENO);
+    close(stdout_fd);
+    fclose(out);
+}
+
+/*
+ * run all jobs of a manifest on num_threads threads
+ */
+inline void run_batch(const string& manifest, unsigned int max_d,
+                      unsigned int dm, double p, unsigned int num_threads,
+                      bool use_cache, bool normalize) {
+    vector<unique_ptr<batch_job>> jobs =
+        read_batch_manifest(manifest, max_d, dm, p);
+    // load the networks and collect the top-level subtrees
+    vector<pair<size_t, size_t>> tasks;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        batch_job& job = *jobs[i];
+        cout << "Loading job " << i + 1 << " of " << jobs.size() << " ("
+             << job.mcs_fname << ")...\n"
+             << endl;
+        if (job.names_fname.size() > 0) {
+            job.calc = PoF_calculator(
+                job.mcs_fname,
+                PoF_calculator::read_rxn_name_file(job.names_fname), job.r,
+                normalize);
+        } else if (job.compr_fname.size() == 0) {
+            job.calc = PoF_calculator(job.mcs_fname, normalize);
+        } else {
+            job.calc = PoF_calculator(job.mcs_fname, job.compr_fname, job.r,
+                                      normalize);
+        }
+        job.num_top_level = job.calc.prepare_recursion(job.max_d);
+        for (const Cutset& cs : job.calc.m_MCSs) {
+            job.mcs_bytes +=
+                sizeof(Cutset) + cs.m_active_rxns.capacity() * sizeof(rxn_idx);
+        }
+        job.table_bytes = job.calc.m_cd_table.size() * job.calc.m_r *
+                          sizeof(wide_count);
+        // most expensive (i.e. highest cardinality) subtrees first
+        for (size_t j = job.num_top_level; j-- > 0;) {
+            tasks.push_back(make_pair(i, j));
+        }
+    }
+    cout << "Running " << tasks.size() << " top-level subtrees of "
+         << jobs.size() << " jobs on " << num_threads << " threads...\n"
+         << endl;
+    progressbar prog_bar(tasks.size(), true);
+#pragma omp parallel num_threads(num_threads)
+    {
+        // job of the current recursion state of the thread
+        size_t current = jobs.size();
+        unique_ptr<PoF_calculator::recursion_state> state;
+        double seconds = 0;
+        auto leave_job = [&]() {
+            if (current == jobs.size()) {
+                return;
+            }
+            batch_job& job = *jobs[current];
+#pragma omp critical(batch_flush)
+            {
+                job.calc.add_recursion_state(*state);
+                job.state_bytes = max(job.state_bytes, state->get_memory());
+                job.num_states--;
+                job.thread_seconds += seconds;
+            }
+            state.reset();
+            seconds = 0;
+        };
+#pragma omp for schedule(dynamic, 1)
+        for (size_t t = 0; t < tasks.size(); t++) {
+            if (tasks[t].first != current) {
+                leave_job();
+                current = tasks[t].first;
+                batch_job& job = *jobs[current];
+                state.reset(new PoF_calculator::recursion_state(
+                    job.calc.make_recursion_state()));
+#pragma omp critical(batch_flush)
+                {
+                    job.num_states++;
+                    job.peak_states = max(job.peak_states, job.num_states);
+                }
+            }
+            batch_job& job = *jobs[current];
+            auto start = chrono::steady_clock::now();
+            job.calc.start_recursion(tasks[t].second, job.calc.m_max_d,
+                                     use_cache, *state);
+            seconds += chrono::duration<double>(chrono::steady_clock::now() -
+                                                start)
+                           .count();
+#pragma omp critical
+            { prog_bar.update(); }
+        }
+        leave_job();
+    }
+    cout << "\n\n" << endl;
+    // results per job and p
+    Table table{{"job", "d0", "p", "lower bound", "polynomial PoF",
+                 "upper bound", "memory (MB)", "thread-seconds"},
+                {5, 5, 12, 23, 23, 23, 12, 15},
+                {"%.5g", "%.5g", "%.3g", "%.15e", "%.15e", "%.15e", "%.4g",
+                 "%.4g"}};
+    table.print_header();
+    for (size_t i = 0; i < jobs.size(); i++) {
+        batch_job& job = *jobs[i];
+        write_batch_results(job);
+        double memory = (job.mcs_bytes + job.table_bytes +
+                         job.peak_states * job.state_bytes) /
+                        1048576.0;
+        for (double job_p : job.ps) {
+            double lower, upper;
+            tie(lower, upper) = job.calc.get_PoF_bounds(job_p, job.dm);
+            double polynomial = get<0>(job.calc.get_final_PoF(
+                job.calc.convert_table(job.calc.m_cd_table), job_p));
+            table.print_row(vector<double>{(double)i + 1,
+                                           (double)job.calc.m_max_d, job_p,
+                                           lower, polynomial, upper, memory,
+                                           job.thread_seconds});
+        }
+    }
+    cout << "\nFull results in the output files of the jobs (memory: MCSs, "
+            "result table and the peak number of recursion states)"
+         << endl;
+}
+
+#endif /* BATCH_HPP */
@@ -2,7 +2,10 @@
 #define COMBINATORICS_HPP
 
 #include "types.hpp"
+#include <algorithm>
 #include <boost/math/special_functions/binomial.hpp>
+#include <iostream>
+#include <stdlib.h>
 #include <vector>
 
 using namespace std;
@@ -16,6 +19,48 @@ template <typename T> T binom(T n, T k) {
     return result;
 }
 
+/**
+ * where the last count overflow of the calling thread happened (nullptr -->
+ * none). the checked arithmetic only records the overflow; the calculator
+ * running the recursion decides whether it stops the program (see
+ * PoF_calculator::check_count_overflow).
+ */
+inline const char*& count_overflow() {
+    static thread_local const char* where = nullptr;
+    return where;
+}
+
+/**
+ * arithmetic on counts that records an overflowing result (the counts are
+ * used in parallel regions --> no exceptions)
+ */
+inline wide_count checked_mul(wide_count a, wide_count b, const char* where) {
+    wide_count result;
+    if (__builtin_mul_overflow(a, b, &result)) {
+        count_overflow() = where;
+    }
+    return result;
+}
+
+inline wide_count checked_add(wide_count a, wide_count b, const char* where) {
+    wide_count result;
+    if (__builtin_add_overflow(a, b, &result)) {
+        count_overflow() = where;
+    }
+    return result;
+}
+
+/**
+ * exact binomial coefficient (C(n - k + i, i) for i = 1..k)
+ */
+inline wide_count exact_binom(unsigned int n, unsigned int k) {
+    wide_count result = 1;
+    for (unsigned int i = 1; i <= k; i++) {
+        result = checked_mul(result, n - k + i, "exact_binom") / i;
+    }
+    return result;
+}
+
 /**
  * print Matrix for debugging
  */
@@ -72,15 +117,15 @@ template <typename T> Matrix<T> get_NSRs(vector<T> NCRs) {
  * possible combinations.
  */
 template <typename T>
-vector<T> get_combs(const vector<T>& NCRs, const Matrix<T>& NSRs) {
-    vector<T> result;
+vector<wide_count> get_combs(const vector<T>& NCRs, const Matrix<T>& NSRs) {
+    vector<wide_count> result;
     result.reserve(NSRs.size());
-    unsigned int prod;
+    wide_count prod;
     for (auto const& row : NSRs) {
         prod = 1;
         for (size_t i = 0; i < NCRs.size(); i++) {
-            T n = NCRs[i];
-            prod *= binom(n, row[i]);
+            prod = checked_mul(prod, exact_binom(NCRs[i], row[i]),
+                               "get_combs");
         }
         result.push_back(prod);
     }
@@ -115,9 +160,9 @@ double binom_dist_weight(T1 n, T2 k, double p = 0.5) {
  * can cache results.
  */
 template <typename T>
-pair<vector<T>, vector<T>> get_Mjs_and_counts(const vector<T>& NCRs,
-                                              bool use_cache = true) {
-    static map<vector<T>, pair<vector<T>, vector<T>>> cache;
+pair<vector<T>, vector<wide_count>>
+get_Mjs_and_counts(const vector<T>& NCRs, bool use_cache = true) {
+    static map<vector<T>, pair<vector<T>, vector<wide_count>>> cache;
     if (use_cache) {
         // search the cache table
         auto search = cache.find(NCRs);
@@ -125,19 +170,28 @@ pair<vector<T>, vector<T>> get_Mjs_and_counts(const vector<T>& NCRs,
             return search->second;
         }
     }
-    // result not found --> calculate it and add to cache
+    // result not found --> calculate it and add to cache (unless it
+    // overflowed, the cache outlives the calculator recording the overflow)
+    const char* prev_overflow = count_overflow();
+    count_overflow() = nullptr;
     Matrix<T> NSRs = get_NSRs(NCRs);
-    vector<T> counts = get_combs(NCRs, NSRs);
+    vector<wide_count> counts = get_combs(NCRs, NSRs);
+    bool overflow = (count_overflow() != nullptr);
+    if (!overflow) {
+        count_overflow() = prev_overflow;
+    }
     vector<T> Mjs;
     Mjs.reserve(NSRs.size());
     for (size_t i = 0; i < NSRs.size(); i++) {
         Mjs.push_back(sum_vec(NSRs[i]));
     }
-    if (use_cache) {
+    if (use_cache && !overflow) {
 #pragma omp critical
-        { cache[NCRs] = pair<vector<T>, vector<T>>{Mjs, counts}; }
+        {
+            cache[NCRs] = pair<vector<T>, vector<wide_count>>{Mjs, counts};
+        }
     }
-    return pair<vector<T>, vector<T>>{Mjs, counts};
+    return pair<vector<T>, vector<wide_count>>{Mjs, counts};
 }
 
 /*
@@ -145,25 +199,203 @@ pair<vector<T>, vector<T>> get_Mjs_and_counts(const vector<T>& NCRs,
  * result in PoF_calculator.hpp
  */
 template <typename T>
-map<size_t, int>
+map<size_t, wide_count>
 resolve_compressed_cutset(const vector<T>& NCRs, unsigned int max_d,
                           unsigned int depth = 1, bool use_cache = true) {
-    map<size_t, int> table;
+    map<size_t, wide_count> table;
     unsigned int Mj, J, m = NCRs.size();
-    char sign;
     auto Mjs_counts = get_Mjs_and_counts(NCRs, use_cache);
     auto Mjs = Mjs_counts.first;
     auto counts = Mjs_counts.second;
     for (size_t i = 0; i < Mjs.size(); i++) {
         Mj = Mjs[i];
         J = depth + Mj - m;
-        sign = (J % 2) ? 1 : -1;
         if (Mj > max_d) {
             continue;
         }
-        table[Mj] += round((int)counts[i] * sign);
+        table[Mj] = checked_add(table[Mj], (J % 2) ? counts[i] : -counts[i],
+                                "resolve_compressed_cutset");
+    }
+    return table;
+}
+
+/*
+ * resolve a cut set of the gene-level model (a column is hit if any of its
+ * genes is deleted) returning a table like resolve_compressed_cutset. every
+ * column is given by the genes that may still be deleted (i.e. that aren't in
+ * a plus 1 or essential column). columns sharing genes aren't independent -->
+ * the columns are split into connected components and all columns of a
+ * component are hit with sum_S (-1)^|S| * (1 - x)^|genes(S)| over the subsets
+ * S of its columns, where x^k stands for the deletion of k specific genes. a
+ * component of one column with n genes gives 1 - (1 - x)^n as in the
+ * compressed case. the product over the components is truncated at max_d.
+ */
+inline map<size_t, wide_count>
+resolve_gene_level_cutset(const Matrix<unsigned int>& col_genes,
+                          unsigned int max_d, unsigned int depth = 1) {
+    // union-find over the columns that share genes
+    size_t n = col_genes.size();
+    vector<size_t> parent(n);
+    for (size_t i = 0; i < n; i++) {
+        parent[i] = i;
+    }
+    auto find_root = [&parent](size_t i) {
+        while (parent[i] != i) {
+            i = parent[i] = parent[parent[i]];
+        }
+        return i;
+    };
+    vector<pair<unsigned int, size_t>> gene_cols;
+    for (size_t i = 0; i < n; i++) {
+        for (unsigned int gene : col_genes[i]) {
+            gene_cols.push_back(make_pair(gene, i));
+        }
+    }
+    sort(gene_cols.begin(), gene_cols.end());
+    for (size_t i = 1; i < gene_cols.size(); i++) {
+        if (gene_cols[i].first == gene_cols[i - 1].first) {
+            parent[find_root(gene_cols[i].second)] =
+                find_root(gene_cols[i - 1].second);
+        }
+    }
+    Matrix<size_t> components(n);
+    for (size_t i = 0; i < n; i++) {
+        components[find_root(i)].push_back(i);
+    }
+    vector<wide_count> poly(max_d + 1, 0), comp_poly(max_d + 1),
+        product(max_d + 1);
+    poly[0] = 1;
+    for (const vector<size_t>& comp : components) {
+        if (comp.size() == 0) {
+            continue;
+        }
+        fill(comp_poly.begin(), comp_poly.end(), 0);
+        // number of subsets S (with sign) per number of genes in S
+        vector<long> num_subsets;
+        if (comp.size() == 1) {
+            num_subsets.assign(col_genes[comp[0]].size() + 1, 0);
+            num_subsets[0] = 1;
+            num_subsets.back() -= 1;
+        } else {
+            if (comp.size() > 30) {
+                cout << "Error: more than 30 columns sharing genes in a cut "
+                        "set (reduce d0)"
+                     << endl;
+                exit(EXIT_FAILURE);
+            }
+            // genes of the component numbered locally
+            vector<unsigned int> genes;
+            for (size_t i : comp) {
+                genes.insert(genes.end(), col_genes[i].begin(),
+                             col_genes[i].end());
+            }
+            sort(genes.begin(), genes.end());
+            genes.erase(unique(genes.begin(), genes.end()), genes.end());
+            Matrix<size_t> local(comp.size());
+            for (size_t c = 0; c < comp.size(); c++) {
+                for (unsigned int gene : col_genes[comp[c]]) {
+                    local[c].push_back(
+                        lower_bound(genes.begin(), genes.end(), gene) -
+                        genes.begin());
+                }
+            }
+            // go through the subsets in Gray code order --> one column is
+            // added or removed per step
+            num_subsets.assign(genes.size() + 1, 0);
+            vector<unsigned int> gene_count(genes.size(), 0);
+            size_t num_genes = 0;
+            num_subsets[0] = 1;
+            for (unsigned long i = 1; i < (1ul << comp.size()); i++) {
+                unsigned long gray = i ^ (i >> 1);
+                size_t c = __builtin_ctzl(i);
+                if (gray & (1ul << c)) {
+                    for (size_t g : local[c]) {
+                        num_genes += (gene_count[g]++ == 0);
+                    }
+                } else {
+                    for (size_t g : local[c]) {
+                        num_genes -= (--gene_count[g] == 0);
+                    }
+                }
+                num_subsets[num_genes] +=
+                    (__builtin_popcountl(gray) % 2) ? -1 : 1;
+            }
+        }
+        // expand (1 - x)^m
+        for (size_t m = 0; m < num_subsets.size(); m++) {
+            if (num_subsets[m] == 0) {
+                continue;
+            }
+            for (size_t k = 0; (k <= m) && (k <= max_d); k++) {
+                wide_count term = checked_mul(exact_binom(m, k),
+                                              (k % 2) ? -num_subsets[m]
+                                                      : num_subsets[m],
+                                              "resolve_gene_level_cutset");
+                comp_poly[k] = checked_add(comp_poly[k], term,
+                                           "resolve_gene_level_cutset");
+            }
+        }
+        // poly <- poly * comp_poly
+        fill(product.begin(), product.end(), 0);
+        for (size_t k1 = 0; k1 <= max_d; k1++) {
+            if (poly[k1] == 0) {
+                continue;
+            }
+            for (size_t k2 = 1; k1 + k2 <= max_d; k2++) {
+                product[k1 + k2] = checked_add(
+                    product[k1 + k2],
+                    checked_mul(poly[k1], comp_poly[k2],
+                                "resolve_gene_level_cutset"),
+                    "resolve_gene_level_cutset");
+            }
+        }
+        poly.swap(product);
+    }
+    map<size_t, wide_count> table;
+    for (size_t k = 1; k <= max_d; k++) {
+        if (poly[k] != 0) {
+            table[k] = (depth % 2) ? poly[k] : -poly[k];
+        }
     }
     return table;
 }
 
+/*
+ * polynomial for the condition that none of the given pairs of (compressed)
+ * rxns has both rxns deleted. the number of compressed rxns of the two
+ * columns of every pair is given in NCR_pairs. a column with n rxns is hit
+ * if at least one of them is deleted --> h(x) = 1 - (1 - x)^n, where x^k
+ * stands for the deletion of k specific uncompressed rxns. the pairs are
+ * disjoint --> the polynomial is the product of (1 - h_1(x) * h_2(x)) over
+ * all pairs. truncated at max_deg.
+ */
+template <typename T>
+vector<long> get_pair_correction(const vector<pair<T, T>>& NCR_pairs,
+                                 unsigned int max_deg) {
+    vector<long> poly(max_deg + 1, 0), both(max_deg + 1);
+    poly[0] = 1;
+    for (const auto& NCR_pair : NCR_pairs) {
+        // coefficients of h_1(x) * h_2(x) (binomial coefficients built up
+        // iteratively)
+        fill(both.begin(), both.end(), 0);
+        long c1 = 1;
+        for (T m1 = 1; (m1 <= NCR_pair.first) && (m1 < max_deg); m1++) {
+            c1 = c1 * (NCR_pair.first - m1 + 1) / m1;
+            long c2 = 1;
+            for (T m2 = 1; (m2 <= NCR_pair.second) && (m1 + m2 <= max_deg);
+                 m2++) {
+                c2 = c2 * (NCR_pair.second - m2 + 1) / m2;
+                both[m1 + m2] += (((m1 + m2) % 2) ? -1 : 1) * c1 * c2;
+            }
+        }
+        // poly <- poly * (1 - h_1 * h_2)
+        for (size_t k = max_deg + 1; k-- > 0;) {
+            for (size_t m = 2; m <= k; m++) {
+                poly[k] -= both[m] * poly[k - m];
+            }
+        }
+    }
+    return poly;
+}
+
 #endif /*  COMBINATORICS_HPP */
@@ -1,10 +1,12 @@
 #ifndef COMMAND_LINE_ARGS_HPP
 #define COMMAND_LINE_ARGS_HPP
 
+#include "cpu_features.hpp"
 #include <iomanip>
 #include <ios>
 #include <iostream>
 #include <sstream>
+#include <stdint.h>
 #include <string>
 #include <vector>
 using namespace std;
@@ -12,6 +14,7 @@ using namespace std;
 struct parsed_options {
     string mcs_fname;
     string compr_rxn_fname;
+    string rxn_names_fname;
     unsigned int num_uncompressed_rxns = 0;
     unsigned int max_d = 0;
     unsigned int threads = 1;
@@ -19,9 +22,33 @@ struct parsed_options {
     unsigned int dm = 0;
     bool use_cache = true;
     bool print_poly = false;
+    bool stream = false;
+    bool normalize = false;
+    bool reorder = false;
+    bool components = false;
+    bool auto_compress = false;
+    unsigned int exhaustive_max_cols = 26;
+    string zdd_order;
+    string simd_level;
+    double time_limit = 0;
+    double report_interval = 0;
+    unsigned int max_order = 0;
+    size_t num_samples = 0;
+    string query_fname;
+    string scenario_fname;
+    size_t num_attributions = 0;
+    string rxn_probs_fname;
+    string genes_fname;
+    string serve_path;
+    string batch_fname;
+    bool prefixes = false;
+    uint64_t seed = 0;
 
     void print() {
         cout << "MCSs from " << mcs_fname << endl;
+        if (rxn_names_fname.size() > 0) {
+            cout << "reaction names from " << rxn_names_fname << endl;
+        }
         if (compr_rxn_fname.size() > 0) {
             cout << "compressed reaction numbers from " << compr_rxn_fname << endl;
             cout << num_uncompressed_rxns << " uncompressed reactions" << endl;
@@ -34,6 +61,79 @@ struct parsed_options {
         if (print_poly) {
             cout << "printing polynomial" << endl;
         }
+        if (stream) {
+            cout << "streaming MCS file" << endl;
+        }
+        if (normalize) {
+            cout << "normalizing MCSs" << endl;
+        }
+        if (reorder) {
+            cout << "reordering reactions" << endl;
+        }
+        if (components) {
+            cout << "splitting into independent components" << endl;
+        }
+        if (auto_compress) {
+            cout << "merging interchangeable reactions" << endl;
+        }
+        cout << "exhaustive enumeration for up to " << exhaustive_max_cols
+             << " columns" << endl;
+        if (zdd_order.size() > 0) {
+            cout << "using ZDD engine (" << zdd_order << " variable order)"
+                 << endl;
+        }
+        if (max_order > 0) {
+            cout << "inclusion-exclusion up to order " << max_order << endl;
+        }
+        if (query_fname.size() > 0) {
+            cout << "answering lethality queries from "
+                 << ((query_fname == "-") ? "stdin" : query_fname) << endl;
+        }
+        if (scenario_fname.size() > 0) {
+            cout << "conditional PoF for the scenarios in " << scenario_fname
+                 << endl;
+        }
+        if (rxn_probs_fname.size() > 0) {
+            cout << "rxn probabilities from " << rxn_probs_fname << endl;
+        }
+        if (prefixes) {
+            cout << "reporting the PoF for every MCS-prefix cutoff dm'"
+                 << endl;
+        }
+        if (batch_fname.size() > 0) {
+            cout << "batch of the jobs in " << batch_fname << endl;
+        }
+        if (serve_path.size() > 0) {
+            cout << "serving requests on "
+                 << ((serve_path == "-") ? "stdin/stdout" : serve_path)
+                 << endl;
+        }
+        if (genes_fname.size() > 0) {
+            cout << "gene-level PoF with the genes from " << genes_fname
+                 << endl;
+        }
+        if (num_attributions > 0) {
+            cout << "reporting the " << num_attributions
+                 << " MCSs and reactions contributing most to the PoF" << endl;
+        }
+        if (num_samples > 0) {
+            cout << "Monte Carlo estimate with " << num_samples
+                 << " samples per number of deletions (seed " << seed << ")"
+                 << endl;
+        }
+        if (time_limit > 0) {
+            cout << "time limit of " << time_limit << " s" << endl;
+        }
+        if (report_interval > 0) {
+            cout << "reporting bounds every " << report_interval << " s"
+                 << endl;
+        }
+        cout << get_simd_level_name(get_simd_level()) << " kernels";
+        if (get_simd_level() != detect_simd_level()) {
+            cout << " (CPU supports "
+                 << get_simd_level_name(detect_simd_level()) << ")";
+        }
+        cout << endl;
     }
 };
 
@@ -96,6 +196,13 @@ void print_help() {
          "compressed "
          "reactions per column in MCS file (e.g. '1 1 3 1 2...'). "
          "If not provided, assumes uncompressed network."},
+        {"-f, --rfile",
+         "file with whitespace-separated reaction names (e.g. rfile or "
+         "rfile_comp). If provided, the MCS file is expected to hold lists "
+         "of reaction names separated by spaces or commas (e.g. "
+         "defigueiredo output) instead of binary strings. Numbers of "
+         "compressed reactions are derived from names joined by '%' "
+         "(i.e. -c is not required and can't be combined with -f)."},
         {"-r, --rxns", "number of reactions in the uncompressed network; not "
                        "required for uncompressed case. "
                        "[default=sum of numbers in compr. rxn file]"},
@@ -110,15 +217,144 @@ void print_help() {
          "provide this flag to disable caching results when resolving "
          "compressed cutsets"},
         {"-l, --poly", "print polynomial at the end"},
+        {"-s, --stream",
+         "read the MCS file in a separate thread and start the recursion "
+         "while it is still being read. MCSs with cardinality > d0 are "
+         "skipped. Requires the MCS file to be sorted by cardinality."},
+        {"-z, --normalize",
+         "sort the MCSs by cardinality and remove duplicates and "
+         "non-minimal cut sets before the recursion (i.e. the MCS file does "
+         "not need to be sorted or minimal)."},
+        {"-o, --reorder",
+         "renumber reactions by frequency (dropping those that are not in "
+         "any MCS with d <= d0) to improve memory locality. the order of "
+         "the MCSs and the results are unchanged."},
+        {"-k, --components",
+         "split the MCSs into independent components (i.e. groups that "
+         "share no reactions), run the recursion for each of them in "
+         "parallel and combine the results."},
+        {"-a, --auto_compr",
+         "merge reactions that are interchangeable with respect to the MCSs "
+         "into compressed columns (i.e. compress the network without "
+         "external tools)."},
+        {"-e, --exhaustive",
+         "max. number of columns (after reduction) for which all deletion "
+         "sets are enumerated instead of running the recursion. Yields the "
+         "exact F(d) for all d. Applies to independent components as well. "
+         "0 disables it. [default=26, max=30]"},
+        {"-y, --zdd",
+         "count the lethal deletion sets with a zero-suppressed decision "
+         "diagram of all MCSs instead of running the recursion. Yields the "
+         "exact F(d) for all d <= d0 and scales with d0 much better than "
+         "the recursion (the PoF from these counts is a lower bound for "
+         "d0 < r). Takes the variable order heuristic: 'appearance' "
+         "(order of first appearance in the MCSs), 'frequency' or 'index'."},
+        {"-j, --max_order",
+         "truncate the inclusion-exclusion of the recursion after the given "
+         "number of MCSs (i.e. its depth). Yields Bonferroni lower and "
+         "upper bounds of F(d) from this order and the one below at a "
+         "fraction of the cost. Doesn't apply to the exhaustive and ZDD "
+         "engines (they are exact). Can't be combined with -s, -k, -b or "
+         "-i. [default=unlimited]"},
+        {"-b, --time_limit",
+         "stop the recursion after the given number of seconds. The "
+         "results of the MCSs whose recursion is not finished are replaced "
+         "by upper bounds --> the PoF bounds remain valid. Can't be "
+         "combined with -s or -k. [default=no limit]"},
+        {"-i, --report",
+         "print a lower and upper bound of the PoF (using only the MCSs "
+         "whose recursion is finished) every given number of seconds. "
+         "Can't be combined with -s or -k."},
+        {"-u, --samples",
+         "additionally estimate F(d) for the d not covered exactly (i.e. d "
+         "> d0) by sampling the given number of random deletion sets per "
+         "number of deletions in the columns of the MCSs. Prints the "
+         "estimates and the resulting PoF with 95% confidence intervals. "
+         "Uses all MCSs (also those with d > d0). Can't be combined with "
+         "-s. [default=0, i.e. no sampling]"},
+        {"-g, --seed",
+         "seed of the random number generators for -u. The estimates don't "
+         "depend on the number of threads. [default=0]"},
+        {"-w, --query",
+         "file with deletion sets (one per line, '-' for stdin) to check for "
+         "lethality (i.e. whether they contain an MCS) instead of "
+         "calculating the PoF. Deletion sets are binary strings over the "
+         "columns of the MCS file or over the uncompressed reactions (the "
+         "ones of every column numbered consecutively) or, with -f, names "
+         "of columns or uncompressed reactions. Prints 1 (lethal), 0 or "
+         "'invalid' per line. Can't be combined with -s, -a or -u."},
+        {"-v, --scenarios",
+         "file with background deletion sets (one per line, in the formats "
+         "of -w) for which the conditional PoF (i.e. of the mutant with "
+         "these reactions deleted) is calculated instead of the PoF of the "
+         "network. Deleting a reaction of a compressed column deletes the "
+         "whole column. The scenarios run in parallel with one thread "
+         "each. Can't be combined with -s, -a, -k, -y, -j, -b, -i, -u or "
+         "-w."},
+        {"-P, --rxn_probs",
+         "file with whitespace-separated failure probabilities, one per "
+         "uncompressed reaction (the ones of every column numbered "
+         "consecutively) or one per column. Additionally reports the PoF "
+         "for these probabilities, computed exactly by the recursion (with "
+         "the default d0). Disables the exhaustive engine. Can't be "
+         "combined with -s, -k, -a, -o, -y, -j, -b, -i, -w or -v."},
+        {"-C, --cutoffs",
+         "additionally report the PoF bounds for the MCSs up to every "
+         "cardinality dm' <= dm (all cardinalities <= d0 if dm isn't set), "
+         "as separate runs on prefixes of the MCS file would, from a single "
+         "recursion. The MCS file has to be sorted by cardinality (or use "
+         "-z). Disables the exhaustive engine. Can't be combined with -s, "
+         "-k, -a, -o, -y, -j, -b, -i, -w, -v, -P, -S or -B."},
+        {"-B, --batch",
+         "manifest with many networks (one job per line: mcs=FILE "
+         "[comp=FILE] [names=FILE] [r=N] [d0=N] [dm=N] [p=P1,P2,...] "
+         "[out=FILE], see src/batch.hpp) whose top-level subtrees share one "
+         "pool of -t threads instead of -m. d0, dm and p default to -d, -q "
+         "and -p. Writes the results per job to its output file (default: "
+         "MCS file + '.pof') and a summary to stdout. Can't be combined "
+         "with -s, -k, -a, -o, -y, -j, -b, -i, -u, -w, -v, -P, -A, -G or "
+         "-S."},
+        {"-S, --serve",
+         "keep the network of -m (and networks loaded later) in memory and "
+         "answer requests (one JSON object per line, see src/server.hpp and "
+         "scripts/pofcalc_client.py) on the given Unix socket or, with '-', "
+         "on stdin/stdout: PoF for other p/dm/d0 (the results of the "
+         "recursion are cached per d0), lethality checks and conditional "
+         "PoF. -p, -q and -d are the defaults of the requests. Can't be "
+         "combined with -s, -k, -a, -o, -y, -j, -b, -i, -u, -w, -v, -P, -A "
+         "or -G."},
+        {"-G, --genes",
+         "file with the genes of every column (one line per column of the "
+         "MCS file, gene names separated by whitespace, commas or 'and'). "
+         "Calculates the PoF for the deletion of genes instead of "
+         "reactions: a column fails if any of its genes fails. Columns can "
+         "share genes. Disables the exhaustive engine. Can't be combined "
+         "with -s, -k, -a, -o, -y, -b, -i, -u, -w, -v, -P or -A."},
+        {"-A, --attribution",
+         "attribute the PoF to the MCSs (probability of being the first MCS "
+         "hit, depends on the order of the MCSs) and reactions (derivative "
+         "of the PoF with respect to the failure probability of every "
+         "reaction) during the recursion and print the given number of "
+         "largest ones. Disables the exhaustive engine. Can't be combined with "
+         "-s, -k, -a, -o, -y, -j, -b, -i, -w or -v."},
+        {"-x, --simd",
+         "instruction set of the vectorized kernels: 'scalar', 'sse4.2', "
+         "'avx2' or 'avx512'. Fails if the CPU doesn't support it. "
+         "[default=best supported by the CPU]"},
         {"-h, --help", "print this message"}};
     wrap_in_field(header, 75);
     cout << endl << endl;
     cout << "Usage:" << endl;
     wrap_in_field({"PoFcalc -m MCS_file [OPTIONS...]"}, 50, 0, 3);
     cout << endl << endl;
+    // column of the option names (at least one space after the longest)
+    unsigned int name_width = 0;
+    for (const auto& opt : options) {
+        name_width = max(name_width, (unsigned int)opt[0].size() + 1);
+    }
     for (const auto& opt : options) {
-        wrap_in_field(opt[0], 15, 0, 3);
-        wrap_in_field(opt[1], 50, 18, 0);
+        wrap_in_field(opt[0], name_width, 0, 3);
+        wrap_in_field(opt[1], 50, name_width + 3, 0);
         cout << endl << endl;
     }
 }
@@ -144,6 +380,9 @@ parsed_options parse_cmd_line(int argc, char* argv[]) {
         } else if ((argument == "-c") || (argument == "--compr")) {
             parsed_options.compr_rxn_fname = argv[i + 1];
             i++;
+        } else if ((argument == "-f") || (argument == "--rfile")) {
+            parsed_options.rxn_names_fname = argv[i + 1];
+            i++;
         } else if ((argument == "-r") || (argument == "--rxns")) {
             parsed_options.num_uncompressed_rxns = atoi(argv[i + 1]);
             i++;
@@ -169,12 +408,271 @@ parsed_options parse_cmd_line(int argc, char* argv[]) {
             parsed_options.use_cache = false;
         } else if ((argument == "-l") || (argument == "--poly")) {
             parsed_options.print_poly = true;
+        } else if ((argument == "-s") || (argument == "--stream")) {
+            parsed_options.stream = true;
+        } else if ((argument == "-z") || (argument == "--normalize")) {
+            parsed_options.normalize = true;
+        } else if ((argument == "-o") || (argument == "--reorder")) {
+            parsed_options.reorder = true;
+        } else if ((argument == "-k") || (argument == "--components")) {
+            parsed_options.components = true;
+        } else if ((argument == "-a") || (argument == "--auto_compr")) {
+            parsed_options.auto_compress = true;
+        } else if ((argument == "-e") || (argument == "--exhaustive")) {
+            parsed_options.exhaustive_max_cols = atoi(argv[i + 1]);
+            i++;
+        } else if ((argument == "-y") || (argument == "--zdd")) {
+            string order(argv[i + 1]);
+            if ((order != "appearance") && (order != "frequency") &&
+                (order != "index")) {
+                cout << "ERROR: unknown ZDD variable order '" << order
+                     << "'\n" << endl;
+                print_help();
+                exit(1);
+            }
+            parsed_options.zdd_order = order;
+            i++;
+        } else if ((argument == "-j") || (argument == "--max_order")) {
+            parsed_options.max_order = atoi(argv[i + 1]);
+            i++;
+        } else if ((argument == "-b") || (argument == "--time_limit")) {
+            parsed_options.time_limit = atof(argv[i + 1]);
+            i++;
+        } else if ((argument == "-i") || (argument == "--report")) {
+            parsed_options.report_interval = atof(argv[i + 1]);
+            i++;
+        } else if ((argument == "-w") || (argument == "--query")) {
+            parsed_options.query_fname = argv[i + 1];
+            i++;
+        } else if ((argument == "-v") || (argument == "--scenarios")) {
+            parsed_options.scenario_fname = argv[i + 1];
+            i++;
+        } else if ((argument == "-P") || (argument == "--rxn_probs")) {
+            parsed_options.rxn_probs_fname = argv[i + 1];
+            i++;
+        } else if ((argument == "-C") || (argument == "--cutoffs")) {
+            parsed_options.prefixes = true;
+        } else if ((argument == "-B") || (argument == "--batch")) {
+            parsed_options.batch_fname = argv[i + 1];
+            i++;
+        } else if ((argument == "-S") || (argument == "--serve")) {
+            parsed_options.serve_path = argv[i + 1];
+            i++;
+        } else if ((argument == "-G") || (argument == "--genes")) {
+            parsed_options.genes_fname = argv[i + 1];
+            i++;
+        } else if ((argument == "-A") || (argument == "--attribution")) {
+            parsed_options.num_attributions = strtoull(argv[i + 1], NULL, 10);
+            i++;
+        } else if ((argument == "-u") || (argument == "--samples")) {
+            parsed_options.num_samples = strtoull(argv[i + 1], NULL, 10);
+            i++;
+        } else if ((argument == "-g") || (argument == "--seed")) {
+            parsed_options.seed = strtoull(argv[i + 1], NULL, 10);
+            i++;
+        } else if ((argument == "-x") || (argument == "--simd")) {
+            string level(argv[i + 1]);
+            try {
+                set_simd_level(parse_simd_level(level));
+            } catch (const exception& e) {
+                cout << "ERROR: " << e.what() << "\n" << endl;
+                exit(1);
+            }
+            parsed_options.simd_level = level;
+            i++;
         } else {
             cout << argv[i] << endl;
             print_help();
             exit(2);
         }
     }
+    if ((parsed_options.rxn_names_fname.size() > 0) &&
+        (parsed_options.compr_rxn_fname.size() > 0)) {
+        cout << "ERROR: with reaction names the numbers of compressed "
+                "reactions are derived from the names --> -c can't be "
+                "combined with -f\n"
+             << endl;
+        exit(1);
+    }
+    if (parsed_options.stream && parsed_options.rxn_names_fname.size() > 0) {
+        cout << "ERROR: streaming requires a binary MCS file\n" << endl;
+        exit(1);
+    }
+    if (parsed_options.stream && parsed_options.auto_compress) {
+        cout << "ERROR: streaming can't be combined with merging "
+                "interchangeable reactions\n"
+             << endl;
+        exit(1);
+    }
+    if (parsed_options.stream && parsed_options.normalize) {
+        cout << "ERROR: streaming requires a sorted MCS file and can't be "
+                "combined with normalizing\n"
+             << endl;
+        exit(1);
+    }
+    if (parsed_options.stream && parsed_options.zdd_order.size() > 0) {
+        cout << "ERROR: streaming can't be combined with the ZDD engine\n"
+             << endl;
+        exit(1);
+    }
+    if ((parsed_options.query_fname.size() > 0) &&
+        (parsed_options.stream || parsed_options.auto_compress ||
+         (parsed_options.num_samples > 0))) {
+        cout << "ERROR: lethality queries can't be combined with streaming, "
+                "merging interchangeable reactions or sampling\n"
+             << endl;
+        exit(1);
+    }
+    if ((parsed_options.scenario_fname.size() > 0) &&
+        (parsed_options.stream || parsed_options.auto_compress ||
+         parsed_options.components || (parsed_options.zdd_order.size() > 0) ||
+         (parsed_options.max_order > 0) || (parsed_options.time_limit > 0) ||
+         (parsed_options.report_interval > 0) ||
+         (parsed_options.num_samples > 0) ||
+         (parsed_options.query_fname.size() > 0))) {
+        cout << "ERROR: scenarios can't be combined with streaming, merging "
+                "interchangeable reactions, independent components, the ZDD "
+                "engine, truncating the inclusion-exclusion, a time limit, "
+                "reports, sampling or lethality queries\n"
+             << endl;
+        exit(1);
+    }
+    if ((parsed_options.num_attributions > 0) &&
+        (parsed_options.stream || parsed_options.components ||
+         parsed_options.auto_compress || parsed_options.reorder ||
+         (parsed_options.zdd_order.size() > 0) ||
+         (parsed_options.max_order > 0) || (parsed_options.time_limit > 0) ||
+         (parsed_options.report_interval > 0) ||
+         (parsed_options.query_fname.size() > 0) ||
+         (parsed_options.scenario_fname.size() > 0))) {
+        cout << "ERROR: the attribution requires the plain recursion and "
+                "can't be combined with streaming, independent components, "
+                "merging interchangeable reactions, reordering, the ZDD "
+                "engine, truncating the inclusion-exclusion, a time limit, "
+                "reports, lethality queries or scenarios\n"
+             << endl;
+        exit(1);
+    }
+    if ((parsed_options.rxn_probs_fname.size() > 0) &&
+        (parsed_options.stream || parsed_options.components ||
+         parsed_options.auto_compress || parsed_options.reorder ||
+         (parsed_options.zdd_order.size() > 0) ||
+         (parsed_options.max_order > 0) || (parsed_options.time_limit > 0) ||
+         (parsed_options.report_interval > 0) ||
+         (parsed_options.query_fname.size() > 0) ||
+         (parsed_options.scenario_fname.size() > 0))) {
+        cout << "ERROR: rxn probabilities require the plain recursion and "
+                "can't be combined with streaming, independent components, "
+                "merging interchangeable reactions, reordering, the ZDD "
+                "engine, truncating the inclusion-exclusion, a time limit, "
+                "reports, lethality queries or scenarios\n"
+             << endl;
+        exit(1);
+    }
+    if (parsed_options.prefixes &&
+        (parsed_options.stream || parsed_options.components ||
+         parsed_options.auto_compress || parsed_options.reorder ||
+         (parsed_options.zdd_order.size() > 0) ||
+         (parsed_options.max_order > 0) || (parsed_options.time_limit > 0) ||
+         (parsed_options.report_interval > 0) ||
+         (parsed_options.query_fname.size() > 0) ||
+         (parsed_options.scenario_fname.size() > 0) ||
+         (parsed_options.rxn_probs_fname.size() > 0) ||
+         (parsed_options.serve_path.size() > 0) ||
+         (parsed_options.batch_fname.size() > 0))) {
+        cout << "ERROR: the prefix cutoffs require the plain recursion and "
+                "can't be combined with streaming, independent components, "
+                "merging interchangeable reactions, reordering, the ZDD "
+                "engine, truncating the inclusion-exclusion, a time limit, "
+                "reports, lethality queries, scenarios, rxn probabilities, "
+                "the server or the batch mode\n"
+             << endl;
+        exit(1);
+    }
+    if ((parsed_options.batch_fname.size() > 0) &&
+        (parsed_options.stream || parsed_options.components ||
+         parsed_options.auto_compress || parsed_options.reorder ||
+         (parsed_options.zdd_order.size() > 0) ||
+         (parsed_options.max_order > 0) || (parsed_options.time_limit > 0) ||
+         (parsed_options.report_interval > 0) ||
+         (parsed_options.num_samples > 0) ||
+         (parsed_options.query_fname.size() > 0) ||
+         (parsed_options.scenario_fname.size() > 0) ||
+         (parsed_options.rxn_probs_fname.size() > 0) ||
+         (parsed_options.num_attributions > 0) ||
+         (parsed_options.genes_fname.size() > 0) ||
+         (parsed_options.serve_path.size() > 0))) {
+        cout << "ERROR: the batch mode can't be combined with streaming, "
+                "independent components, merging interchangeable reactions, "
+                "reordering, the ZDD engine, truncating the "
+                "inclusion-exclusion, a time limit, reports, sampling, "
+                "lethality queries, scenarios, rxn probabilities, the "
+                "attribution, genes or the server\n"
+             << endl;
+        exit(1);
+    }
+    if ((parsed_options.serve_path.size() > 0) &&
+        (parsed_options.stream || parsed_options.components ||
+         parsed_options.auto_compress || parsed_options.reorder ||
+         (parsed_options.zdd_order.size() > 0) ||
+         (parsed_options.max_order > 0) || (parsed_options.time_limit > 0) ||
+         (parsed_options.report_interval > 0) ||
+         (parsed_options.num_samples > 0) ||
+         (parsed_options.query_fname.size() > 0) ||
+         (parsed_options.scenario_fname.size() > 0) ||
+         (parsed_options.rxn_probs_fname.size() > 0) ||
+         (parsed_options.num_attributions > 0) ||
+         (parsed_options.genes_fname.size() > 0))) {
+        cout << "ERROR: the server can't be combined with streaming, "
+                "independent components, merging interchangeable reactions, "
+                "reordering, the ZDD engine, truncating the "
+                "inclusion-exclusion, a time limit, reports, sampling, "
+                "lethality queries, scenarios, rxn probabilities, the "
+                "attribution or genes\n"
+             << endl;
+        exit(1);
+    }
+    if ((parsed_options.genes_fname.size() > 0) &&
+        (parsed_options.stream || parsed_options.components ||
+         parsed_options.auto_compress || parsed_options.reorder ||
+         (parsed_options.zdd_order.size() > 0) ||
+         (parsed_options.time_limit > 0) ||
+         (parsed_options.report_interval > 0) ||
+         (parsed_options.num_samples > 0) ||
+         (parsed_options.query_fname.size() > 0) ||
+         (parsed_options.scenario_fname.size() > 0) ||
+         (parsed_options.rxn_probs_fname.size() > 0) ||
+         (parsed_options.num_attributions > 0))) {
+        cout << "ERROR: the gene-level PoF requires the plain recursion and "
+                "can't be combined with streaming, independent components, "
+                "merging interchangeable reactions, reordering, the ZDD "
+                "engine, a time limit, reports, sampling, lethality queries, "
+                "scenarios, rxn probabilities or the attribution\n"
+             << endl;
+        exit(1);
+    }
+    if (parsed_options.stream && (parsed_options.num_samples > 0)) {
+        cout << "ERROR: streaming can't be combined with sampling\n" << endl;
+        exit(1);
+    }
+    if (((parsed_options.time_limit > 0) ||
+         (parsed_options.report_interval > 0)) &&
+        (parsed_options.stream || parsed_options.components)) {
+        cout << "ERROR: time limit and reports can't be combined with "
+                "streaming or independent components\n"
+             << endl;
+        exit(1);
+    }
+    if ((parsed_options.max_order > 0) &&
+        (parsed_options.stream || parsed_options.components ||
+         (parsed_options.time_limit > 0) ||
+         (parsed_options.report_interval > 0))) {
+        cout << "ERROR: truncating the inclusion-exclusion can't be combined "
+                "with streaming, independent components, a time limit or "
+                "reports\n"
+             << endl;
+        exit(1);
+    }
     return parsed_options;
 }
 
@@ -0,0 +1,79 @@
+#ifndef CPU_FEATURES_HPP
+#define CPU_FEATURES_HPP
+
+#include <stdexcept>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_FEATURES_X86
+#endif
+using namespace std;
+
+/*
+ * instruction set levels of the kernels that are compiled for several CPUs.
+ * the binary itself is built for the baseline of the architecture and the
+ * level (i.e. the variant of the kernels) is chosen at runtime. it defaults
+ * to the highest level supported by the CPU and can be lowered with
+ * set_simd_level() (e.g. for benchmarking or to work around a faulty path).
+ */
+enum simd_level { SIMD_SCALAR, SIMD_SSE42, SIMD_AVX2, SIMD_AVX512 };
+
+const char* const SIMD_LEVEL_NAMES[] = {"scalar", "sse4.2", "avx2", "avx512"};
+
+/*
+ * highest level supported by the CPU the program runs on
+ */
+inline simd_level detect_simd_level() {
+#ifdef CPU_FEATURES_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("popcnt")) {
+        return SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+        return SIMD_SSE42;
+    }
+#endif
+    return SIMD_SCALAR;
+}
+
+inline simd_level& current_simd_level() {
+    static simd_level level = detect_simd_level();
+    return level;
+}
+
+inline simd_level get_simd_level() {
+    return current_simd_level();
+}
+
+inline const char* get_simd_level_name(simd_level level) {
+    return SIMD_LEVEL_NAMES[level];
+}
+
+/*
+ * select the kernels of a given level. throws if the CPU doesn't support it.
+ */
+inline void set_simd_level(simd_level level) {
+    if (level > detect_simd_level()) {
+        throw runtime_error(string("CPU does not support ") +
+                            get_simd_level_name(level) + " kernels");
+    }
+    current_simd_level() = level;
+}
+
+/*
+ * level for a name in SIMD_LEVEL_NAMES. throws for unknown names.
+ */
+inline simd_level parse_simd_level(const string& name) {
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX512; level++) {
+        if (name == SIMD_LEVEL_NAMES[level]) {
+            return (simd_level)level;
+        }
+    }
+    throw invalid_argument("unknown SIMD level '" + name + "'");
+}
+
+#endif /* CPU_FEATURES_HPP */
@@ -2,6 +2,7 @@
 #define CUTSET_HPP
 
 #include "combinatorics.hpp"
+#include "set_kernels.hpp"
 #include "types.hpp"
 #include <algorithm>
 #include <iostream>
@@ -22,6 +23,12 @@ using namespace std;
 typedef unsigned int rxn_idx;
 
 
+/**
+ * pair of reactions that must not both be deleted
+ */
+typedef pair<rxn_idx, rxn_idx> rxn_pair;
+
+
 /**
  * check whether x is in vec
  */
@@ -56,13 +63,20 @@ public:
 	vector<rxn_idx> get_active_rxns() const;
 	size_t get_first_active_rxn() const;
 	void add_reaction(rxn_idx);
+	bool has_rxn(rxn_idx) const;
 	Cutset remove_rxns(const vector<rxn_idx> &) const;
 	tuple<bool, bool, rxn_idx> find_plus1_rxn(const Cutset &) const;
+	rxn_pair find_plus2_rxns(const Cutset &) const;
 
 private:
 	void extract_active_rxns_from_string(const string &);
 };
 
+tuple<bool, bool, rxn_idx> find_plus1_rxn_in(const rxn_idx *, const rxn_idx *,
+                                             const Cutset &);
+rxn_pair find_plus2_rxns_in(const rxn_idx *, const rxn_idx *,
+                            const Cutset &);
+
 
 /*
  * construct empty instance with a given number of reactions.
@@ -84,11 +98,7 @@ Cutset::Cutset(const string &cs){
  * get positions of deletions in a binary string
  */
 void Cutset::extract_active_rxns_from_string(const string &cs){
-	for (size_t i = 0; i < cs.length(); i++) {
-		if (cs[i] == '1') {
-			m_active_rxns.push_back(i);
-		}
-	}
+	find_ones(cs, m_active_rxns);
 }
 
 
@@ -118,11 +128,12 @@ inline unsigned int Cutset::CARDINALITY() const {
  */
 inline Cutset Cutset::operator | (const Cutset &other_CS) const {
 	Cutset new_cs(m_len);
-	new_cs.m_active_rxns.reserve(m_active_rxns.size() +
-	                             other_CS.m_active_rxns.size());
-	set_union(begin(m_active_rxns), end(m_active_rxns),
-	          begin(other_CS.m_active_rxns), end(other_CS.m_active_rxns),
-	          back_inserter(new_cs.m_active_rxns));
+	new_cs.m_active_rxns.resize(m_active_rxns.size() +
+	                            other_CS.m_active_rxns.size());
+	new_cs.m_active_rxns.resize(set_union_into(
+	    m_active_rxns.data(), m_active_rxns.size(),
+	    other_CS.m_active_rxns.data(), other_CS.m_active_rxns.size(),
+	    new_cs.m_active_rxns.data()));
 	return new_cs;
 }
 
@@ -132,23 +143,9 @@ inline Cutset Cutset::operator | (const Cutset &other_CS) const {
  * in common
  */
 inline bool Cutset::operator && (const Cutset &other_CS) const {
-	auto first1 = m_active_rxns.begin();
-	auto last1 = m_active_rxns.end();
-	auto first2 = other_CS.m_active_rxns.begin();
-	auto last2 = other_CS.m_active_rxns.end();
-	while (first1 != last1) {
-		if (first2 == last2)
-			return false;
-		if (*first2 < *first1) {
-			first2++;
-		} else {
-			if (*first1 == *first2) {
-				return true;
-			}
-			++first1;
-		}
-	}
-	return false;
+	return sets_intersect(m_active_rxns.data(), m_active_rxns.size(),
+	                      other_CS.m_active_rxns.data(),
+	                      other_CS.m_active_rxns.size());
 }
 
 
@@ -174,30 +171,18 @@ size_t Cutset::get_first_active_rxn() const {
  */
 Cutset Cutset::remove_rxns(const vector<rxn_idx> &del_rxns) const {
 	Cutset new_cs(m_len - del_rxns.size());
-	new_cs.m_active_rxns.reserve(m_active_rxns.size());
-
-	auto first1 = m_active_rxns.cbegin();
-	auto last1 = m_active_rxns.cend();
-	auto first2 = del_rxns.cbegin();
-	auto last2 = del_rxns.cend();
-
-	size_t del_rxn_count = 0;
-	while (first1 != last1) {
-		if (first2 == last2) {
-			for (; first1 != last1; first1++) {
-				new_cs.m_active_rxns.push_back(*first1 - del_rxn_count);
-			}
-			break;
-		}
-		if (*first2 <= *first1) {
-			del_rxn_count++;
-			if (*first1 == *first2) {
-				first1++;
-			}
-			first2++;
-		} else {
-			new_cs.m_active_rxns.push_back(*first1++ - del_rxn_count);
-		}
+	new_cs.m_active_rxns.resize(m_active_rxns.size());
+	rxn_idx last;
+	new_cs.m_active_rxns.resize(set_difference_into(
+	    m_active_rxns.data(), m_active_rxns.size(), del_rxns.data(),
+	    del_rxns.size(), new_cs.m_active_rxns.data(), &last));
+
+	// shift the remaining indices by the number of deleted reactions before
+	// them
+	auto del_itr = del_rxns.cbegin();
+	for (rxn_idx &rxn : new_cs.m_active_rxns) {
+		del_itr = lower_bound(del_itr, del_rxns.cend(), rxn);
+		rxn -= del_itr - del_rxns.cbegin();
 	}
 	return new_cs;
 }
@@ -217,6 +202,14 @@ void Cutset::add_reaction(rxn_idx new_rxn){
 }
 
 
+/*
+ * check whether a reaction is deleted in the cut set
+ */
+inline bool Cutset::has_rxn(rxn_idx rxn) const {
+	return binary_search(m_active_rxns.begin(), m_active_rxns.end(), rxn);
+}
+
+
 /**
  * loops over another cutset and returns whether
  *      -) there is only a single additional reaction active (i.e. not present
@@ -230,43 +223,64 @@ void Cutset::add_reaction(rxn_idx new_rxn){
  *      extra reactions
  */
 tuple<bool, bool, rxn_idx> Cutset::find_plus1_rxn(const Cutset &other_CS) const {
+	return find_plus1_rxn_in(m_active_rxns.data(),
+	                         m_active_rxns.data() + m_active_rxns.size(),
+	                         other_CS);
+}
+
+
+/*
+ * same as Cutset::find_plus1_rxn for a cut set given as a sorted array of
+ * deletions in [first1, last1) (e.g. in the arena memory of the recursion)
+ */
+tuple<bool, bool, rxn_idx> find_plus1_rxn_in(const rxn_idx *first1,
+                                             const rxn_idx *last1,
+                                             const Cutset &other_CS) {
 	typedef tuple<bool, bool, rxn_idx> result;
-	auto first1 = m_active_rxns.begin();
-	auto last1 = m_active_rxns.end();
-	auto first2 = other_CS.m_active_rxns.begin();
-	auto last2 = other_CS.m_active_rxns.end();
-	unsigned int plus1_rxn_count = 0;
-	rxn_idx plus1_rxn_idx;
-	while (first1 != last1) {
-		if (first2 == last2)
-			break;
-		if (*first2 < *first1) {
-			plus1_rxn_idx = *first2++;
-			plus1_rxn_count++;
-			// if (plus1_rxn_count > 1) {
-			// 	return result {false, true, 0};
-			// }
-		} else {
-			if (*first1 == *first2) {
-				*first2++;
-			}
-			first1++;
-		}
-	}
-	if (last2 - first2) {
-		plus1_rxn_count += last2 - first2;
-		plus1_rxn_idx = *(last2 - 1);
-		// if (plus1_rxn_count > 1) {
-		// 	return result {false, true, 0};
-		// }
-	}
+	rxn_idx plus1_rxn_idx = 0;
+	size_t plus1_rxn_count = set_difference_into(
+	    other_CS.m_active_rxns.data(), other_CS.m_active_rxns.size(), first1,
+	    last1 - first1, NULL, &plus1_rxn_idx);
 	if (plus1_rxn_count == 1) {
 		return result {true, false, plus1_rxn_idx};
 	} else if (plus1_rxn_count == 0) {
 		return result {false, false, 0};
 	} else {
-		return result {false, true, plus1_rxn_count};
+		return result {false, true, (rxn_idx) plus1_rxn_count};
+	}
+}
+
+
+/*
+ * return the two reactions of another cut set that are not present in this
+ * one. requires find_plus1_rxn to have found exactly 2 extra reactions.
+ */
+rxn_pair Cutset::find_plus2_rxns(const Cutset &other_CS) const {
+	return find_plus2_rxns_in(m_active_rxns.data(),
+	                          m_active_rxns.data() + m_active_rxns.size(),
+	                          other_CS);
+}
+
+
+/*
+ * same as Cutset::find_plus2_rxns for a cut set given as a sorted array
+ */
+rxn_pair find_plus2_rxns_in(const rxn_idx *first1, const rxn_idx *last1,
+                            const Cutset &other_CS) {
+	rxn_idx extra[2] = {0, 0};
+	unsigned int num_extra = 0;
+	for (rxn_idx rxn : other_CS.m_active_rxns) {
+		while (first1 != last1 && *first1 < rxn) {
+			first1++;
+		}
+		if (first1 == last1 || *first1 != rxn) {
+			extra[num_extra++] = rxn;
+			if (num_extra == 2) {
+				break;
+			}
+		}
 	}
+	return rxn_pair(extra[0], extra[1]);
 }
 
 #endif
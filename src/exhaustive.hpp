@@ -0,0 +1,233 @@
+#ifndef EXHAUSTIVE_HPP
+#define EXHAUSTIVE_HPP
+
+#include "combinatorics.hpp"
+#include "cpu_features.hpp"
+#include "cutset.hpp"
+#include "types.hpp"
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+/*
+ * bit-parallel exhaustive counting of lethal deletion sets for small networks
+ * (or small independent components). every subset of the n columns is a
+ * position in a bit array of size 2^n (64 subsets per machine word). the bits
+ * of the MCSs are set first and then propagated to all supersets, which
+ * yields the lethality of every subset after n passes over the array. all
+ * passes are plain word-wise ANDs, ORs and shifts that are parallelized with
+ * OpenMP and vectorized by the compiler.
+ */
+
+// max. number of columns for the exhaustive engine (2^30 bits = 128 MB)
+const unsigned int EXHAUSTIVE_MAX_COLS = 30;
+// max. number of uncompressed rxns --> lethal counts fit into a long
+const unsigned int EXHAUSTIVE_MAX_RXNS = 66;
+
+/*
+ * add the lethal subsets in a word of the bit array to the counts of their
+ * tuples (high_offset is the tuple offset of the word and low_offsets holds
+ * the positions within the word per tuple offset). compiled for the baseline
+ * and with the popcnt instruction, selected by get_simd_level().
+ */
+inline __attribute__((always_inline)) void
+add_tuple_counts(long* counts, size_t high_offset, uint64_t word,
+                 const vector<pair<size_t, uint64_t>>& low_offsets) {
+    for (const auto& elem : low_offsets) {
+        counts[high_offset + elem.first] +=
+            __builtin_popcountll(word & elem.second);
+    }
+}
+
+inline void add_tuple_counts_scalar(
+    long* counts, size_t high_offset, uint64_t word,
+    const vector<pair<size_t, uint64_t>>& low_offsets) {
+    add_tuple_counts(counts, high_offset, word, low_offsets);
+}
+
+#ifdef CPU_FEATURES_X86
+__attribute__((target("popcnt"))) inline void add_tuple_counts_popcnt(
+    long* counts, size_t high_offset, uint64_t word,
+    const vector<pair<size_t, uint64_t>>& low_offsets) {
+    add_tuple_counts(counts, high_offset, word, low_offsets);
+}
+#endif
+
+/*
+ * bit masks selecting the positions within a word whose index has bit b
+ * unset (for b < 6)
+ */
+const uint64_t LOW_BIT_MASKS[6] = {
+    0x5555555555555555ULL, 0x3333333333333333ULL, 0x0F0F0F0F0F0F0F0FULL,
+    0x00FF00FF00FF00FFULL, 0x0000FFFF0000FFFFULL, 0x00000000FFFFFFFFULL};
+
+/*
+ * set the bit of every subset of the columns that contains at least one MCS
+ */
+vector<uint64_t> get_lethal_subsets(const vector<Cutset>& MCSs,
+                                    unsigned int num_cols,
+                                    unsigned int num_threads) {
+    size_t num_words = (num_cols > 6) ? (size_t)1 << (num_cols - 6) : 1;
+    vector<uint64_t> lethal(num_words, 0);
+    for (const Cutset& cs : MCSs) {
+        uint64_t mask = 0;
+        for (rxn_idx rxn : cs.m_active_rxns) {
+            mask |= (uint64_t)1 << rxn;
+        }
+        lethal[mask >> 6] |= (uint64_t)1 << (mask & 63);
+    }
+    // propagate to supersets within the words
+    for (unsigned int b = 0; (b < 6) && (b < num_cols); b++) {
+        uint64_t low = LOW_BIT_MASKS[b];
+        unsigned int shift = 1 << b;
+#pragma omp parallel for num_threads(num_threads)
+        for (size_t w = 0; w < num_words; w++) {
+            lethal[w] |= (lethal[w] & low) << shift;
+        }
+    }
+    // propagate to supersets across words
+    for (unsigned int b = 6; b < num_cols; b++) {
+        size_t stride = (size_t)1 << (b - 6);
+#pragma omp parallel for num_threads(num_threads)
+        for (size_t w = 0; w < num_words; w++) {
+            if (w & stride) {
+                lethal[w] |= lethal[w ^ stride];
+            }
+        }
+    }
+    return lethal;
+}
+
+/*
+ * count the lethal deletion sets of every cardinality for the uncompressed
+ * rxns in the given columns. compr_rxn_counts holds the number of rxns per
+ * column (empty in the uncompressed case). a column is deleted as soon as any
+ * of its rxns is deleted. returns a vector with the number of lethal sets
+ * with k deletions at position k.
+ */
+vector<long> count_lethal_sets(const vector<Cutset>& MCSs,
+                               unsigned int num_cols,
+                               const vector<unsigned int>& compr_rxn_counts,
+                               unsigned int num_threads = 1) {
+    vector<unsigned int> counts = compr_rxn_counts;
+    if (counts.size() == 0) {
+        counts = vector<unsigned int>(num_cols, 1);
+    }
+    // group the columns by their number of compressed rxns. subsets are
+    // counted by the number of selected columns in each group (mixed radix
+    // index)
+    vector<unsigned int> group_sizes, group_rxns;
+    vector<size_t> col_radix(num_cols);
+    map<unsigned int, size_t> group_ids;
+    for (unsigned int col = 0; col < num_cols; col++) {
+        if (group_ids.find(counts[col]) == group_ids.end()) {
+            group_ids[counts[col]] = group_sizes.size();
+            group_sizes.push_back(0);
+            group_rxns.push_back(counts[col]);
+        }
+        group_sizes[group_ids[counts[col]]]++;
+    }
+    vector<size_t> group_radix(group_sizes.size());
+    size_t num_tuples = 1;
+    for (size_t g = 0; g < group_sizes.size(); g++) {
+        group_radix[g] = num_tuples;
+        num_tuples *= group_sizes[g] + 1;
+    }
+    for (unsigned int col = 0; col < num_cols; col++) {
+        col_radix[col] = group_radix[group_ids[counts[col]]];
+    }
+    // tuple offsets of the subsets within a word (grouped by offset) and of
+    // the high bits (two lookup tables with up to 12 bits each)
+    unsigned int num_low = (num_cols < 6) ? num_cols : 6;
+    map<size_t, uint64_t> low_masks;
+    for (unsigned int pos = 0; pos < ((unsigned int)1 << num_low); pos++) {
+        size_t offset = 0;
+        for (unsigned int col = 0; col < num_low; col++) {
+            if (pos & (1 << col)) {
+                offset += col_radix[col];
+            }
+        }
+        low_masks[offset] |= (uint64_t)1 << pos;
+    }
+    vector<pair<size_t, uint64_t>> low_offsets(low_masks.begin(),
+                                               low_masks.end());
+    unsigned int num_high = num_cols - num_low;
+    unsigned int num_high1 = num_high / 2, num_high2 = num_high - num_high1;
+    vector<size_t> high_offsets1(1 << num_high1, 0),
+        high_offsets2(1 << num_high2, 0);
+    for (size_t w = 0; w < high_offsets1.size(); w++) {
+        for (unsigned int bit = 0; bit < num_high1; bit++) {
+            if (w & (1 << bit)) {
+                high_offsets1[w] += col_radix[num_low + bit];
+            }
+        }
+    }
+    for (size_t w = 0; w < high_offsets2.size(); w++) {
+        for (unsigned int bit = 0; bit < num_high2; bit++) {
+            if (w & (1 << bit)) {
+                high_offsets2[w] += col_radix[num_low + num_high1 + bit];
+            }
+        }
+    }
+
+    // count the lethal subsets per tuple
+    vector<uint64_t> lethal = get_lethal_subsets(MCSs, num_cols, num_threads);
+    vector<long> tuple_counts(num_tuples, 0);
+    size_t high1_mask = high_offsets1.size() - 1;
+    auto count_word = add_tuple_counts_scalar;
+#ifdef CPU_FEATURES_X86
+    if (get_simd_level() >= SIMD_SSE42) {
+        count_word = add_tuple_counts_popcnt;
+    }
+#endif
+#pragma omp parallel num_threads(num_threads)
+    {
+        vector<long> local_counts(num_tuples, 0);
+#pragma omp for
+        for (size_t w = 0; w < lethal.size(); w++) {
+            if (lethal[w] == 0) {
+                continue;
+            }
+            size_t high_offset = high_offsets1[w & high1_mask] +
+                                 high_offsets2[w >> num_high1];
+            count_word(local_counts.data(), high_offset, lethal[w],
+                       low_offsets);
+        }
+#pragma omp critical
+        {
+            for (size_t t = 0; t < num_tuples; t++) {
+                tuple_counts[t] += local_counts[t];
+            }
+        }
+    }
+
+    // resolve the columns: selecting a column with n rxns corresponds to
+    // deleting at least one of them --> polynomial (1 + x)^n - 1
+    size_t num_rxns = sum_vec(counts);
+    vector<long> result(num_rxns + 1, 0);
+    for (size_t t = 0; t < num_tuples; t++) {
+        if (tuple_counts[t] == 0) {
+            continue;
+        }
+        vector<long> poly{1};
+        for (size_t g = 0; g < group_sizes.size(); g++) {
+            size_t k = (t / group_radix[g]) % (group_sizes[g] + 1);
+            for (size_t i = 0; i < k; i++) {
+                vector<long> new_poly(poly.size() + group_rxns[g], 0);
+                for (size_t deg = 0; deg < poly.size(); deg++) {
+                    for (unsigned int sel = 1; sel <= group_rxns[g]; sel++) {
+                        new_poly[deg + sel] +=
+                            poly[deg] * binom<long>(group_rxns[g], sel);
+                    }
+                }
+                poly = new_poly;
+            }
+        }
+        for (size_t deg = 0; deg < poly.size(); deg++) {
+            result[deg] += tuple_counts[t] * poly[deg];
+        }
+    }
+    return result;
+}
+
+#endif /* EXHAUSTIVE_HPP */
@@ -1,5 +1,8 @@
 #include "PoF_calculator.hpp"
+#include "batch.hpp"
 #include "command_line_args.hpp"
+#include "server.hpp"
+#include <omp.h>
 
 using namespace std;
 
@@ -8,23 +11,131 @@ int main(int argc, char* argv[]){
 	// parse command line arguments
 	parsed_options cmd_opts = parse_cmd_line(argc, argv);
 
+	// keep stdout for the responses when serving on stdin/stdout
+	int response_fd = STDOUT_FILENO;
+	if (cmd_opts.serve_path == "-") {
+		response_fd = redirect_stdout_to_stderr();
+	}
+
 	// print command line args
 	cout << "Running PoFcalc:\n";
 	cmd_opts.print();
 	cout << string(22, '-') << endl << endl;
 
+	// default number of threads for parallel pre-processing
+	omp_set_num_threads(cmd_opts.threads);
+
+	// run the jobs of a manifest on one pool of threads if requested
+	if (cmd_opts.batch_fname.size() > 0) {
+		run_batch(cmd_opts.batch_fname, cmd_opts.max_d, cmd_opts.dm,
+		          cmd_opts.p, cmd_opts.threads, cmd_opts.use_cache,
+		          cmd_opts.normalize);
+		return 0;
+	}
+
 	// instantiate calculator class for compressed or uncompressed case
 	PoF_calculator calc;
-	if (cmd_opts.compr_rxn_fname.size() == 0) {                 // uncompressed
-		calc = PoF_calculator(cmd_opts.mcs_fname);
+	if (cmd_opts.stream) {
+		// read MCS file while recursing
+		if (cmd_opts.compr_rxn_fname.size() > 0) {
+			calc.set_compression(cmd_opts.compr_rxn_fname,
+			                     cmd_opts.num_uncompressed_rxns);
+		}
+		calc.stream_cardinalities(cmd_opts.mcs_fname, cmd_opts.max_d,
+		                          cmd_opts.threads, cmd_opts.use_cache);
 	} else {
-		calc = PoF_calculator(cmd_opts.mcs_fname,               // compressed
-		                      cmd_opts.compr_rxn_fname,
-		                      cmd_opts.num_uncompressed_rxns);
-	}
+		if (cmd_opts.rxn_names_fname.size() > 0) {              // rxn names
+			calc = PoF_calculator(
+			    cmd_opts.mcs_fname,
+			    PoF_calculator::read_rxn_name_file(cmd_opts.rxn_names_fname),
+			    cmd_opts.num_uncompressed_rxns, cmd_opts.normalize);
+		} else if (cmd_opts.compr_rxn_fname.size() == 0) {      // uncompressed
+			calc = PoF_calculator(cmd_opts.mcs_fname, cmd_opts.normalize);
+		} else {
+			calc = PoF_calculator(cmd_opts.mcs_fname,           // compressed
+			                      cmd_opts.compr_rxn_fname,
+			                      cmd_opts.num_uncompressed_rxns,
+			                      cmd_opts.normalize);
+		}
+
+		// keep the network in memory and answer requests if requested
+		if (cmd_opts.serve_path.size() > 0) {
+			PoF_server server(cmd_opts.p, cmd_opts.dm, cmd_opts.max_d,
+			                  cmd_opts.threads, cmd_opts.use_cache,
+			                  cmd_opts.exhaustive_max_cols);
+			server.add_family("default", move(calc));
+			if (cmd_opts.serve_path == "-") {
+				server.serve(STDIN_FILENO, response_fd);
+			} else {
+				server.serve_socket(cmd_opts.serve_path);
+			}
+			return 0;
+		}
+
+		// only check deletion sets for lethality if requested
+		if (cmd_opts.query_fname.size() > 0) {
+			calc.answer_queries(cmd_opts.query_fname, cmd_opts.threads);
+			return 0;
+		}
+
+		// only calculate the PoF of mutant backgrounds if requested
+		if (cmd_opts.scenario_fname.size() > 0) {
+			calc.run_scenarios(cmd_opts.scenario_fname, cmd_opts.max_d,
+			                   cmd_opts.p, cmd_opts.dm, cmd_opts.threads,
+			                   cmd_opts.use_cache,
+			                   cmd_opts.exhaustive_max_cols);
+			return 0;
+		}
 
-	// perform recursive cutset search
-	calc.get_cardinalities(cmd_opts.max_d, cmd_opts.threads, cmd_opts.use_cache);
+		// compress the network if requested
+		if (cmd_opts.auto_compress) {
+			calc.merge_equivalent_rxns();
+		}
+
+		// sample deletion sets (before the recursion drops any MCSs)
+		if (cmd_opts.num_samples > 0) {
+			calc.run_sampling(cmd_opts.p, cmd_opts.num_samples, cmd_opts.seed,
+			                  cmd_opts.threads);
+		}
+
+		// gene-level failure model if requested
+		if (cmd_opts.genes_fname.size() > 0) {
+			calc.set_genes(cmd_opts.genes_fname);
+		}
+
+		// heterogeneous failure probabilities if requested
+		if (cmd_opts.rxn_probs_fname.size() > 0) {
+			calc.set_rxn_probs(cmd_opts.rxn_probs_fname);
+		}
+
+		// attribute the PoF to the MCSs and reactions if requested
+		if (cmd_opts.num_attributions > 0) {
+			calc.set_attribution(cmd_opts.p, cmd_opts.num_attributions);
+		}
+
+		// results for every MCS-prefix cutoff if requested
+		if (cmd_opts.prefixes) {
+			calc.set_prefixes();
+		}
+
+		// truncate the inclusion-exclusion if requested
+		if (cmd_opts.max_order > 0) {
+			calc.set_max_order(cmd_opts.max_order);
+		}
+
+		// stop after the time limit and/or report intermediate bounds
+		if ((cmd_opts.time_limit > 0) || (cmd_opts.report_interval > 0)) {
+			calc.set_anytime(cmd_opts.time_limit, cmd_opts.report_interval,
+			                 cmd_opts.p, cmd_opts.dm);
+		}
+
+		// perform recursive cutset search
+		calc.get_cardinalities(cmd_opts.max_d, cmd_opts.threads,
+		                       cmd_opts.use_cache, cmd_opts.reorder,
+		                       cmd_opts.components,
+		                       cmd_opts.exhaustive_max_cols,
+		                       cmd_opts.zdd_order);
+	}
 
 	// print result
 	calc.print_results(cmd_opts.p, cmd_opts.dm, cmd_opts.print_poly);
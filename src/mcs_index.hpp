@@ -0,0 +1,101 @@
+#ifndef MCS_INDEX_HPP
+#define MCS_INDEX_HPP
+
+#include "cutset.hpp"
+#include <vector>
+using namespace std;
+
+/*
+ * inverted index over a family of cut sets: for every reaction it stores the
+ * ids of the cut sets containing it (posting lists). used to check whether a
+ * set of deletions contains any of the indexed cut sets. the check counts for
+ * every indexed cut set how many of its reactions are in the query --> the
+ * cost is linear in the total length of the posting lists of the queried
+ * reactions and not in the number of indexed cut sets.
+ */
+class MCS_index {
+  public:
+    /*
+     * scratch space for queries. every thread needs its own instance.
+     */
+    struct query_buffer {
+        vector<unsigned int> counts;
+        vector<unsigned int> stamps;
+        unsigned int stamp = 0;
+    };
+
+    MCS_index(size_t num_rxns = 0) : m_postings(num_rxns) {
+    }
+
+    /*
+     * add a cut set to the index; its id is the number of previously added
+     * cut sets
+     */
+    void add(const Cutset& cs) {
+        size_t id = m_cards.size();
+        m_cards.push_back(cs.CARDINALITY());
+        for (rxn_idx rxn : cs.m_active_rxns) {
+            m_postings[rxn].push_back(id);
+        }
+    }
+
+    /*
+     * number of indexed cut sets
+     */
+    size_t size() const {
+        return m_cards.size();
+    }
+
+    /*
+     * ids of the indexed cut sets containing a reaction (in ascending order)
+     */
+    const vector<unsigned int>& get_postings(rxn_idx rxn) const {
+        return m_postings[rxn];
+    }
+
+    /*
+     * return the id of an indexed cut set that is a subset of the deletions
+     * in [first, last) or -1 if there is none. returns at the first subset
+     * found.
+     */
+    template <typename It>
+    long find_subset(It first, It last, query_buffer& buf) const {
+        if (buf.counts.size() < m_cards.size()) {
+            buf.counts.resize(m_cards.size());
+            buf.stamps.resize(m_cards.size(), 0);
+        }
+        // new stamp instead of resetting the counts for every query
+        if (++buf.stamp == 0) {
+            fill(buf.stamps.begin(), buf.stamps.end(), 0);
+            buf.stamp = 1;
+        }
+        for (; first != last; ++first) {
+            for (unsigned int id : m_postings[*first]) {
+                if (buf.stamps[id] != buf.stamp) {
+                    buf.stamps[id] = buf.stamp;
+                    buf.counts[id] = 0;
+                }
+                if (++buf.counts[id] == m_cards[id]) {
+                    return id;
+                }
+            }
+        }
+        return -1;
+    }
+
+    /*
+     * convenience overload for a Cutset
+     */
+    long find_subset(const Cutset& cs, query_buffer& buf) const {
+        return find_subset(cs.m_active_rxns.begin(), cs.m_active_rxns.end(),
+                           buf);
+    }
+
+  private:
+    // ids of the cut sets containing each reaction
+    vector<vector<unsigned int>> m_postings;
+    // cardinalities of the indexed cut sets
+    vector<unsigned int> m_cards;
+};
+
+#endif /* MCS_INDEX_HPP */
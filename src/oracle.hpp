@@ -0,0 +1,276 @@
+#ifndef ORACLE_HPP
+#define ORACLE_HPP
+
+#include "cutset.hpp"
+#include "mcs_index.hpp"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// number of queries that are read before they are answered in parallel
+const size_t ORACLE_BATCH_SIZE = 1 << 16;
+// marks essential columns and uncompressed rxns that are not part of any
+// column
+const rxn_idx ESSENTIAL = numeric_limits<rxn_idx>::max();
+const rxn_idx NO_COLUMN = numeric_limits<rxn_idx>::max() - 1;
+
+/*
+ * answers whether deletion sets contain an MCS (i.e. are lethal). the
+ * essential rxns are checked with a lookup table and the other MCSs with an
+ * inverted index (see mcs_index.hpp) that stops at the first contained MCS.
+ * queries are given either in the space of the columns of the MCS file or in
+ * that of the uncompressed rxns (the uncompressed rxns of every column being
+ * numbered consecutively, as in the file with the numbers of compressed
+ * rxns):
+ *   - binary strings with one character per column or per uncompressed rxn
+ *     (with or without the rxns that are not in any column; told apart by
+ *     their length)
+ *   - names of columns or uncompressed rxns (parts of column names joined by
+ *     '%') separated by spaces or commas, if the names of the columns are
+ *     known
+ */
+class Lethality_oracle {
+  public:
+    /*
+     * MCSs of the reduced network (columns without the essential ones as in
+     * PoF_calculator), the sorted essential columns of the original network,
+     * the numbers of uncompressed rxns per original column (empty -->
+     * uncompressed network), the total number of uncompressed rxns (can
+     * include rxns that are not in any column) and the names of the original
+     * columns (optional)
+     */
+    Lethality_oracle(const vector<Cutset>& MCSs, size_t num_reduced_cols,
+                     const vector<rxn_idx>& mcs1_cols,
+                     const vector<unsigned int>& col_counts, size_t num_rxns,
+                     const vector<string>& col_names)
+        : m_index(num_reduced_cols) {
+        for (const Cutset& cs : MCSs) {
+            m_index.add(cs);
+        }
+        // original column --> reduced column (see Cutset::remove_rxns)
+        size_t num_cols = num_reduced_cols + mcs1_cols.size();
+        m_reduced_cols.resize(num_cols);
+        size_t num_mcs1 = 0;
+        for (size_t col = 0; col < num_cols; col++) {
+            if ((num_mcs1 < mcs1_cols.size()) &&
+                (mcs1_cols[num_mcs1] == col)) {
+                m_reduced_cols[col] = ESSENTIAL;
+                num_mcs1++;
+            } else {
+                m_reduced_cols[col] = col - num_mcs1;
+            }
+        }
+        // uncompressed rxn --> original column
+        for (size_t col = 0; col < num_cols; col++) {
+            unsigned int count = (col_counts.size() > 0) ? col_counts[col] : 1;
+            m_rxn_cols.insert(m_rxn_cols.end(), count, col);
+        }
+        m_num_col_rxns = m_rxn_cols.size();
+        m_rxn_cols.resize(max(num_rxns, m_rxn_cols.size()), NO_COLUMN);
+        for (size_t col = 0; col < col_names.size(); col++) {
+            m_col_ids[col_names[col]] = col;
+            // parts of compressed names
+            size_t pos = 0;
+            while (pos <= col_names[col].size()) {
+                size_t end = col_names[col].find('%', pos);
+                if (end == string::npos) {
+                    end = col_names[col].size();
+                }
+                m_col_ids[col_names[col].substr(pos, end - pos)] = col;
+                pos = end + 1;
+            }
+        }
+    }
+
+    /*
+     * parse the deletion set in a query line into the reduced columns it hits
+     * (sorted, without duplicates). returns 1 if it hits an essential column
+     * (cols is incomplete then), -1 if the line can't be parsed and 0
+     * otherwise.
+     */
+    int parse(const string& query, vector<rxn_idx>& cols) const {
+        cols.clear();
+        bool essential = false;
+        if (is_binary(query)) {
+            size_t len = query.find_last_not_of("\r") + 1;
+            if (len == m_reduced_cols.size()) {
+                for (size_t col = 0; col < len; col++) {
+                    if (query[col] == '1') {
+                        essential |= add_column(col, cols);
+                    }
+                }
+            } else if ((len == m_num_col_rxns) || (len == m_rxn_cols.size())) {
+                for (size_t rxn = 0; rxn < len; rxn++) {
+                    if (query[rxn] == '1') {
+                        essential |= add_column(m_rxn_cols[rxn], cols);
+                    }
+                }
+            } else {
+                return -1;
+            }
+        } else {
+            if (m_col_ids.size() == 0) {
+                return -1;
+            }
+            string name;
+            size_t pos = 0;
+            while (pos < query.size()) {
+                size_t end = query.find_first_of(" ,\t\r", pos);
+                if (end == string::npos) {
+                    end = query.size();
+                }
+                if (end > pos) {
+                    name.assign(query, pos, end - pos);
+                    auto search = m_col_ids.find(name);
+                    if (search == m_col_ids.end()) {
+                        return -1;
+                    }
+                    essential |= add_column(search->second, cols);
+                }
+                pos = end + 1;
+            }
+        }
+        if (essential) {
+            return 1;
+        }
+        sort(cols.begin(), cols.end());
+        cols.erase(unique(cols.begin(), cols.end()), cols.end());
+        return 0;
+    }
+
+    /*
+     * reduced columns hit by a deletion set given as original columns, like
+     * parse (-1 for columns out of range)
+     */
+    int get_columns(const rxn_idx* first, const rxn_idx* last,
+                    vector<rxn_idx>& cols) const {
+        cols.clear();
+        bool essential = false;
+        for (const rxn_idx* col = first; col != last; col++) {
+            if (*col >= m_reduced_cols.size()) {
+                return -1;
+            }
+            essential |= add_column(*col, cols);
+        }
+        if (essential) {
+            return 1;
+        }
+        sort(cols.begin(), cols.end());
+        cols.erase(unique(cols.begin(), cols.end()), cols.end());
+        return 0;
+    }
+
+    /*
+     * whether a deletion set given as original columns is lethal (see
+     * is_lethal below)
+     */
+    int is_lethal(const rxn_idx* first, const rxn_idx* last,
+                  vector<rxn_idx>& cols, MCS_index::query_buffer& buf) const {
+        int status = get_columns(first, last, cols);
+        if (status != 0) {
+            return status;
+        }
+        return (m_index.find_subset(cols.begin(), cols.end(), buf) >= 0) ? 1
+                                                                         : 0;
+    }
+
+    /*
+     * whether the deletion set in a query line is lethal (1) or not (0).
+     * returns -1 for lines that can't be parsed. cols and buf are scratch
+     * space (one per thread).
+     */
+    int is_lethal(const string& query, vector<rxn_idx>& cols,
+                  MCS_index::query_buffer& buf) const {
+        int status = parse(query, cols);
+        if (status != 0) {
+            return status;
+        }
+        return (m_index.find_subset(cols.begin(), cols.end(), buf) >= 0) ? 1
+                                                                         : 0;
+    }
+
+    /*
+     * answer the queries in in (one per line) in parallel batches and write
+     * one line per query to out: 1 (lethal), 0 (not lethal) or 'invalid'.
+     * returns the number of invalid queries.
+     */
+    size_t answer(istream& in, ostream& out,
+                  unsigned int num_threads = 1) const {
+        vector<string> queries(ORACLE_BATCH_SIZE);
+        vector<int> results(ORACLE_BATCH_SIZE);
+        size_t num_invalid = 0;
+        while (in) {
+            size_t num_queries = 0;
+            while ((num_queries < ORACLE_BATCH_SIZE) &&
+                   getline(in, queries[num_queries])) {
+                num_queries++;
+            }
+#pragma omp parallel num_threads(num_threads)
+            {
+                vector<rxn_idx> cols;
+                MCS_index::query_buffer buf;
+#pragma omp for schedule(dynamic, 256)
+                for (size_t i = 0; i < num_queries; i++) {
+                    results[i] = is_lethal(queries[i], cols, buf);
+                }
+            }
+            for (size_t i = 0; i < num_queries; i++) {
+                if (results[i] < 0) {
+                    out << "invalid\n";
+                    num_invalid++;
+                } else {
+                    out << results[i] << "\n";
+                }
+            }
+        }
+        out.flush();
+        return num_invalid;
+    }
+
+    /*
+     * index over the MCSs of the reduced network
+     */
+    const MCS_index& get_index() const {
+        return m_index;
+    }
+
+  private:
+    MCS_index m_index;
+    // reduced column of every original column (or ESSENTIAL)
+    vector<rxn_idx> m_reduced_cols;
+    // original column of every uncompressed rxn (or NO_COLUMN) and the
+    // number of uncompressed rxns in the columns
+    vector<rxn_idx> m_rxn_cols;
+    size_t m_num_col_rxns;
+    // original column of every column name and part of a compressed name
+    unordered_map<string, rxn_idx> m_col_ids;
+
+    /*
+     * add the reduced column of an original column to cols. returns true if
+     * the column is essential.
+     */
+    bool add_column(rxn_idx col, vector<rxn_idx>& cols) const {
+        if (col == NO_COLUMN) {
+            return false;
+        }
+        if (m_reduced_cols[col] == ESSENTIAL) {
+            return true;
+        }
+        cols.push_back(m_reduced_cols[col]);
+        return false;
+    }
+
+    /*
+     * whether a query consists of '0's and '1's (and a trailing '\r')
+     */
+    static bool is_binary(const string& query) {
+        size_t len = query.find_last_not_of("\r") + 1;
+        return (len > 0) && (query.find_first_not_of("01") >= len);
+    }
+};
+
+#endif /* ORACLE_HPP */
@@ -0,0 +1,184 @@
+#include "pofcalc.hpp"
+#include "PoF_calculator.hpp"
+
+using namespace std;
+
+static_assert(sizeof(rxn_idx) == sizeof(uint32_t),
+              "column indices of the API must match rxn_idx");
+
+struct PoF_engine::impl {
+    PoF_calculator calc;
+    bool has_MCSs = false, computed = false, verbose = false;
+    // sink for the log of the calculator unless verbose (a stream without
+    // buffer discards everything)
+    ostream null_log{nullptr};
+    // built with the first lethality check
+    unique_ptr<Lethality_oracle> oracle;
+    string error;
+
+    ostream* get_log() {
+        return (verbose) ? &cout : &null_log;
+    }
+
+    bool fail(const string& message) {
+        error = message;
+        return false;
+    }
+
+    /*
+     * check the MCSs and the numbers of compressed rxns and set up the
+     * calculator
+     */
+    bool set_MCSs(vector<Cutset> MCSs, size_t num_cols,
+                  const unsigned int* col_counts, size_t num_rxns,
+                  bool normalize) {
+        has_MCSs = computed = false;
+        oracle.reset();
+        if (MCSs.size() == 0) {
+            return fail("no MCSs given");
+        }
+        for (Cutset& cs : MCSs) {
+            if (cs.m_active_rxns.size() == 0) {
+                return fail("empty MCS");
+            }
+            sort(cs.m_active_rxns.begin(), cs.m_active_rxns.end());
+            if (cs.m_active_rxns.back() >= num_cols) {
+                return fail("column index out of range");
+            }
+            if (adjacent_find(cs.m_active_rxns.begin(),
+                              cs.m_active_rxns.end()) !=
+                cs.m_active_rxns.end()) {
+                return fail("MCS with duplicate columns");
+            }
+        }
+        vector<unsigned int> counts;
+        if (col_counts) {
+            counts.assign(col_counts, col_counts + num_cols);
+            size_t sum = 0;
+            for (unsigned int count : counts) {
+                if (count == 0) {
+                    return fail("column without rxns");
+                }
+                sum += count;
+            }
+            if ((num_rxns > 0) && (num_rxns < sum)) {
+                return fail("fewer rxns than in the columns");
+            }
+        }
+        calc = PoF_calculator(move(MCSs), counts, num_rxns, normalize,
+                              get_log());
+        // overflows are returned as errors instead of stopping the program
+        calc.set_exit_on_overflow(false);
+        has_MCSs = true;
+        return true;
+    }
+};
+
+PoF_engine::PoF_engine() : m_impl(new impl) {
+}
+
+PoF_engine::~PoF_engine() = default;
+PoF_engine::PoF_engine(PoF_engine&&) = default;
+PoF_engine& PoF_engine::operator=(PoF_engine&&) = default;
+
+bool PoF_engine::set_MCSs(const uint64_t* offsets, size_t num_mcs,
+                          const uint32_t* cols, size_t num_cols,
+                          const unsigned int* col_counts, size_t num_rxns,
+                          bool normalize) {
+    vector<Cutset> MCSs;
+    MCSs.reserve(num_mcs);
+    for (size_t i = 0; i < num_mcs; i++) {
+        if (offsets[i + 1] < offsets[i]) {
+            return m_impl->fail("offsets not ascending");
+        }
+        MCSs.emplace_back(num_cols);
+        MCSs.back().m_active_rxns.assign(cols + offsets[i],
+                                         cols + offsets[i + 1]);
+    }
+    return m_impl->set_MCSs(move(MCSs), num_cols, col_counts, num_rxns,
+                            normalize);
+}
+
+bool PoF_engine::set_MCSs(const vector<PoF_mcs_span>& MCSs, size_t num_cols,
+                          const unsigned int* col_counts, size_t num_rxns,
+                          bool normalize) {
+    vector<Cutset> sets;
+    sets.reserve(MCSs.size());
+    for (const PoF_mcs_span& span : MCSs) {
+        sets.emplace_back(num_cols);
+        sets.back().m_active_rxns.assign(span.cols, span.cols + span.size);
+    }
+    return m_impl->set_MCSs(move(sets), num_cols, col_counts, num_rxns,
+                            normalize);
+}
+
+bool PoF_engine::compute(const PoF_options& options) {
+    if (!m_impl->has_MCSs) {
+        return m_impl->fail("no MCSs set");
+    }
+    if (options.num_threads == 0) {
+        return m_impl->fail("no threads");
+    }
+    m_impl->verbose = options.verbose;
+    m_impl->computed = false;
+    m_impl->calc.set_log(*m_impl->get_log());
+    m_impl->calc.get_cardinalities(options.max_d, options.num_threads,
+                                   options.use_cache, false, false,
+                                   options.exhaustive_max_cols);
+    if (m_impl->calc.m_count_overflow) {
+        return m_impl->fail("count overflow (reduce d0)");
+    }
+    m_impl->computed = true;
+    return true;
+}
+
+bool PoF_engine::get_PoF(double p, unsigned int dm, PoF_result& result) {
+    if (!m_impl->computed) {
+        return m_impl->fail("no results (call compute first)");
+    }
+    if ((p <= 0) || (p >= 1)) {
+        return m_impl->fail("p should be between 0 and 1");
+    }
+    PoF_calculator& calc = m_impl->calc;
+    tie(result.lower, result.upper) = calc.get_PoF_bounds(p, dm);
+    result.polynomial =
+        get<0>(calc.get_final_PoF(calc.convert_table(calc.m_cd_table), p));
+    result.num_rxns = calc.m_r;
+    result.max_d = calc.m_max_d;
+    result.F.clear();
+    double score = 0;
+    for (size_t d = 1; d <= calc.m_r; d++) {
+        if (binom_dist_weight(calc.m_r, d, p) < WEIGHT_LIMIT) {
+            break;
+        }
+        score = calc.get_lower_score(d, score);
+        result.F.push_back(score);
+    }
+    return true;
+}
+
+bool PoF_engine::is_lethal(const uint32_t* cols, size_t num_cols,
+                           bool& lethal) {
+    if (!m_impl->has_MCSs) {
+        return m_impl->fail("no MCSs set");
+    }
+    const PoF_calculator& calc = m_impl->calc;
+    if (!m_impl->oracle) {
+        m_impl->oracle.reset(new Lethality_oracle(
+            calc.m_MCSs, calc.m_r_reduced, calc.m_mcs1_rxns,
+            calc.m_column_rxn_counts, calc.m_r, calc.m_column_names));
+    }
+    vector<rxn_idx> reduced_cols;
+    MCS_index::query_buffer buf;
+    int status =
+        m_impl->oracle->is_lethal(cols, cols + num_cols, reduced_cols, buf);
+    if (status < 0) {
+        return m_impl->fail("column index out of range");
+    }
+    lethal = (status > 0);
+    return true;
+}
+
+const string& PoF_engine::get_error() const {
+    return m_impl->error;
+}
@@ -0,0 +1,109 @@
+#ifndef POFCALC_HPP
+#define POFCALC_HPP
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+ * library API of PoFcalc for computing the PoF in-process (build with
+ * 'make lib' and link libpofcalc.a with -fopenmp). the MCSs are handed over
+ * from memory instead of files, errors are returned instead of stopping the
+ * program and the results are returned instead of printed. this header
+ * doesn't depend on the internals (see PoF_calculator.hpp). example:
+ *
+ *   PoF_engine engine;
+ *   if (!engine.set_MCSs(offsets.data(), offsets.size() - 1, cols.data(),
+ *                        num_cols) ||
+ *       !engine.compute(PoF_options()) ||
+ *       !engine.get_PoF(1e-4, 0, result)) {
+ *       cerr << engine.get_error() << endl;
+ *   }
+ */
+
+/*
+ * an MCS as array of the indices of its columns
+ */
+struct PoF_mcs_span {
+    const uint32_t* cols;
+    size_t size;
+};
+
+struct PoF_options {
+    // d0 (0 --> all rxns)
+    unsigned int max_d = 0;
+    unsigned int num_threads = 1;
+    bool use_cache = true;
+    // max. number of columns for the exhaustive engine
+    unsigned int exhaustive_max_cols = 26;
+    // write the log of the calculator to stdout (discarded otherwise)
+    bool verbose = false;
+};
+
+struct PoF_result {
+    // bounds and polynomial PoF (as in the output of PoFcalc)
+    double lower = 0, upper = 1, polynomial = 0;
+    // number of uncompressed rxns and the (corrected) d0
+    size_t num_rxns = 0;
+    unsigned int max_d = 0;
+    // lower bounds of F(d) for d = 1, 2, ... (exact for d <= d0) as long as
+    // the weights are above the threshold
+    std::vector<double> F;
+};
+
+class PoF_engine {
+  public:
+    PoF_engine();
+    ~PoF_engine();
+    PoF_engine(PoF_engine&&);
+    PoF_engine& operator=(PoF_engine&&);
+
+    /*
+     * set the MCSs over num_cols columns from a flat array: the columns of
+     * MCS i are cols[offsets[i]] ... cols[offsets[i + 1] - 1]. col_counts
+     * holds the numbers of uncompressed rxns per column (nullptr -->
+     * uncompressed network) and num_rxns the total number of uncompressed
+     * rxns (0 --> sum of col_counts). the MCSs are expected to be minimal
+     * unless normalize is set.
+     */
+    bool set_MCSs(const uint64_t* offsets, size_t num_mcs,
+                  const uint32_t* cols, size_t num_cols,
+                  const unsigned int* col_counts = nullptr,
+                  size_t num_rxns = 0, bool normalize = false);
+
+    /*
+     * same with one array per MCS
+     */
+    bool set_MCSs(const std::vector<PoF_mcs_span>& MCSs, size_t num_cols,
+                  const unsigned int* col_counts = nullptr,
+                  size_t num_rxns = 0, bool normalize = false);
+
+    /*
+     * run the recursion (or the exhaustive engine) for the MCSs
+     */
+    bool compute(const PoF_options& options);
+
+    /*
+     * PoF for the failure probability p of every rxn, all MCSs with up to dm
+     * columns being known. requires compute().
+     */
+    bool get_PoF(double p, unsigned int dm, PoF_result& result);
+
+    /*
+     * whether the deletion of the given columns is lethal (i.e. contains an
+     * MCS)
+     */
+    bool is_lethal(const uint32_t* cols, size_t num_cols, bool& lethal);
+
+    /*
+     * message of the last failed call
+     */
+    const std::string& get_error() const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> m_impl;
+};
+
+#endif /* POFCALC_HPP */
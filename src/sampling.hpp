@@ -0,0 +1,117 @@
+#ifndef SAMPLING_HPP
+#define SAMPLING_HPP
+
+#include "combinatorics.hpp"
+#include "cutset.hpp"
+#include "mcs_index.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <random>
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+/*
+ * Monte Carlo estimation of the fraction of lethal deletion sets for networks
+ * that are too large for the recursion. the uncompressed rxns in the columns
+ * of the (reduced) MCSs are sampled separately for every number k of
+ * deletions among them (i.e. stratified by k): the fraction q_k of lethal
+ * k-subsets doesn't depend on the total number of deletions d --> the
+ * estimates can be combined with hypergeometric weights for every d (see
+ * PoF_calculator::get_sampled_score).
+ */
+
+// number of samples drawn with the same random number generator. the samples
+// of a stratum are split into blocks with their own generators (seeded by the
+// seed, k and the block) --> the result doesn't depend on the number of
+// threads.
+const size_t SAMPLING_BLOCK_SIZE = 4096;
+
+/*
+ * draw num_samples sets of k distinct uncompressed rxns for every 0 < k <=
+ * max_k and count the ones that contain an MCS. the columns of the MCSs hold
+ * counts[col] uncompressed rxns each (no counts --> uncompressed network).
+ * returns the number of lethal samples per k.
+ */
+inline vector<size_t>
+sample_lethal_sets(const vector<Cutset>& MCSs, size_t num_cols,
+                   const vector<unsigned int>& counts, unsigned int max_k,
+                   size_t num_samples, uint64_t seed,
+                   unsigned int num_threads = 1) {
+    MCS_index index(num_cols);
+    unsigned int min_card = max_k + 1;
+    for (const Cutset& cs : MCSs) {
+        index.add(cs);
+        min_card = min(min_card, cs.CARDINALITY());
+    }
+    // the uncompressed rxns of column col are [first_rxn[col],
+    // first_rxn[col + 1])
+    vector<size_t> first_rxn(num_cols + 1);
+    for (size_t col = 0; col < num_cols; col++) {
+        first_rxn[col + 1] =
+            first_rxn[col] + ((counts.size() > 0) ? counts[col] : 1);
+    }
+    size_t num_rxns = first_rxn.back();
+    max_k = min<size_t>(max_k, num_rxns);
+    vector<size_t> lethal(max_k + 1, 0);
+    // no MCS fits into less than min_card deletions --> only sample the
+    // remaining strata
+    vector<pair<unsigned int, size_t>> blocks;
+    size_t num_blocks =
+        (num_samples + SAMPLING_BLOCK_SIZE - 1) / SAMPLING_BLOCK_SIZE;
+    for (unsigned int k = min_card; k <= max_k; k++) {
+        for (size_t block = 0; block < num_blocks; block++) {
+            blocks.push_back(make_pair(k, block));
+        }
+    }
+#pragma omp parallel num_threads(num_threads)
+    {
+        vector<size_t> local_lethal(max_k + 1, 0);
+        MCS_index::query_buffer buf;
+        vector<size_t> rxns;
+        vector<rxn_idx> cols;
+#pragma omp for schedule(dynamic)
+        for (size_t b = 0; b < blocks.size(); b++) {
+            unsigned int k = blocks[b].first;
+            size_t block = blocks[b].second;
+            seed_seq seq{(uint32_t)seed, (uint32_t)(seed >> 32), k,
+                         (uint32_t)block, (uint32_t)(block >> 32)};
+            mt19937_64 rng(seq);
+            size_t block_end =
+                min(num_samples, (block + 1) * SAMPLING_BLOCK_SIZE);
+            for (size_t i = block * SAMPLING_BLOCK_SIZE; i < block_end; i++) {
+                // k distinct rxns (Floyd's algorithm)
+                rxns.clear();
+                for (size_t j = num_rxns - k; j < num_rxns; j++) {
+                    size_t rxn =
+                        uniform_int_distribution<size_t>(0, j)(rng);
+                    if (find(rxns.begin(), rxns.end(), rxn) != rxns.end()) {
+                        rxn = j;
+                    }
+                    rxns.push_back(rxn);
+                }
+                // columns hit by the deletions
+                cols.clear();
+                for (size_t rxn : rxns) {
+                    cols.push_back(upper_bound(first_rxn.begin(),
+                                               first_rxn.end(), rxn) -
+                                   first_rxn.begin() - 1);
+                }
+                sort(cols.begin(), cols.end());
+                cols.erase(unique(cols.begin(), cols.end()), cols.end());
+                if (index.find_subset(cols.begin(), cols.end(), buf) >= 0) {
+                    local_lethal[k]++;
+                }
+            }
+        }
+#pragma omp critical
+        {
+            for (size_t k = 0; k <= max_k; k++) {
+                lethal[k] += local_lethal[k];
+            }
+        }
+    }
+    return lethal;
+}
+
+#endif /* SAMPLING_HPP */
@@ -0,0 +1,970 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "PoF_calculator.hpp"
+#include <chrono>
+#include <cmath>
+#include <errno.h>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+/*
+ * long-running server that keeps MCS families (i.e. reduced calculators, the
+ * result tables of the recursion per d0 and the lethality oracles) in memory
+ * and answers requests given as one JSON object per line, on stdin/stdout or
+ * on a local Unix socket. every request gets one JSON object per line as
+ * response ({"ok": true, ...} or {"ok": false, "error": ...}; the "id" of the
+ * request is echoed). requests ("family" defaults to "default", "p", "dm" and
+ * "d0" to the values given on the command line):
+ *   {"cmd": "info"}
+ *   {"cmd": "load", "family": name, "mcs": file, "compr": file,
+ *    "names": file, "r": number, "normalize": bool}
+ *   {"cmd": "unload", "family": name}
+ *   {"cmd": "pof", "family": name, "p": number, "dm": number, "d0": number}
+ *     (runs the recursion unless its result for d0 is cached)
+ *   {"cmd": "lethal", "family": name, "sets": [deletion set, ...]}
+ *     (deletion sets in the formats of the lethality oracle)
+ *   {"cmd": "scenario", "family": name, "backgrounds": [deletion set, ...],
+ *    "p": number, "dm": number, "d0": number}
+ *   {"cmd": "shutdown"}
+ */
+
+/*
+ * flat JSON object as used by the requests: the values are strings,
+ * numbers, booleans, null or arrays of these (no nested objects). every value
+ * is kept as a list of scalars with a flag per scalar whether it was a string
+ * (the others keep their literal text).
+ */
+struct json_request {
+    struct value {
+        vector<string> items;
+        vector<char> is_string;
+        bool is_array = false;
+    };
+    map<string, value> values;
+
+    /*
+     * parse a line. returns false (and sets error) if it isn't a flat JSON
+     * object.
+     */
+    bool parse(const string& line, string& error) {
+        size_t pos = 0;
+        values.clear();
+        skip_space(line, pos);
+        if (!expect(line, pos, '{')) {
+            error = "expected a JSON object";
+            return false;
+        }
+        skip_space(line, pos);
+        if ((pos < line.size()) && (line[pos] == '}')) {
+            return true;
+        }
+        while (true) {
+            string key;
+            skip_space(line, pos);
+            if (!parse_string(line, pos, key)) {
+                error = "expected a string as key";
+                return false;
+            }
+            skip_space(line, pos);
+            if (!expect(line, pos, ':')) {
+                error = "expected ':' after key '" + key + "'";
+                return false;
+            }
+            value val;
+            skip_space(line, pos);
+            if ((pos < line.size()) && (line[pos] == '[')) {
+                val.is_array = true;
+                pos++;
+                skip_space(line, pos);
+                if ((pos < line.size()) && (line[pos] == ']')) {
+                    pos++;
+                } else {
+                    while (true) {
+                        skip_space(line, pos);
+                        if (!parse_scalar(line, pos, val)) {
+                            error = "invalid array element of '" + key + "'";
+                            return false;
+                        }
+                        skip_space(line, pos);
+                        if (expect(line, pos, ']')) {
+                            break;
+                        }
+                        if (!expect(line, pos, ',')) {
+                            error = "expected ',' or ']' in '" + key + "'";
+                            return false;
+                        }
+                    }
+                }
+            } else if (!parse_scalar(line, pos, val)) {
+                error = "invalid value of '" + key + "'";
+                return false;
+            }
+            values[key] = val;
+            skip_space(line, pos);
+            if (expect(line, pos, '}')) {
+                return true;
+            }
+            if (!expect(line, pos, ',')) {
+                error = "expected ',' or '}' after '" + key + "'";
+                return false;
+            }
+        }
+    }
+
+    bool has(const string& key) const {
+        return values.count(key) > 0;
+    }
+
+    string get_string(const string& key, const string& fallback = "") const {
+        auto search = values.find(key);
+        if ((search == values.end()) || (search->second.items.size() != 1)) {
+            return fallback;
+        }
+        return search->second.items[0];
+    }
+
+    /*
+     * number (fallback if the key is missing). returns false (and sets error)
+     * for other values.
+     */
+    bool get_number(const string& key, double fallback, double& out,
+                    string& error) const {
+        auto search = values.find(key);
+        if (search == values.end()) {
+            out = fallback;
+            return true;
+        }
+        const string& text =
+            (search->second.items.size() == 1) ? search->second.items[0] : "";
+        char* end = nullptr;
+        out = strtod(text.c_str(), &end);
+        if (search->second.is_array || (text.size() == 0) ||
+            search->second.is_string[0] || (*end != '\0') ||
+            !isfinite(out)) {
+            error = "'" + key + "' should be a number";
+            return false;
+        }
+        return true;
+    }
+
+    /*
+     * non-negative integer (e.g. d0), as get_number
+     */
+    template <typename T>
+    bool get_count(const string& key, T fallback, T& out,
+                   string& error) const {
+        double number;
+        if (!get_number(key, fallback, number, error)) {
+            return false;
+        }
+        if ((number < 0) || (number != floor(number)) ||
+            (number > (double)numeric_limits<T>::max())) {
+            error = "'" + key + "' should be a non-negative integer";
+            return false;
+        }
+        out = (T)number;
+        return true;
+    }
+
+    bool get_bool(const string& key, bool fallback = false) const {
+        string text = get_string(key);
+        return (text.size() > 0) ? (text == "true") : fallback;
+    }
+
+    /*
+     * all scalars of a value (a scalar counts as array with one element)
+     */
+    vector<string> get_array(const string& key) const {
+        auto search = values.find(key);
+        return (search == values.end()) ? vector<string>()
+                                        : search->second.items;
+    }
+
+  private:
+    static void skip_space(const string& line, size_t& pos) {
+        while ((pos < line.size()) && isspace((unsigned char)line[pos])) {
+            pos++;
+        }
+    }
+
+    static bool expect(const string& line, size_t& pos, char c) {
+        if ((pos < line.size()) && (line[pos] == c)) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    /*
+     * string with the escapes of JSON (\u only for ASCII characters)
+     */
+    static bool parse_string(const string& line, size_t& pos, string& out) {
+        out.clear();
+        if (!expect(line, pos, '"')) {
+            return false;
+        }
+        while (pos < line.size()) {
+            char c = line[pos++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= line.size()) {
+                return false;
+            }
+            c = line[pos++];
+            switch (c) {
+            case 'n':
+                out += '\n';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'u':
+                if (pos + 4 > line.size()) {
+                    return false;
+                }
+                out += (char)strtol(line.substr(pos, 4).c_str(), NULL, 16);
+                pos += 4;
+                break;
+            default: // '"', '\\' and '/'
+                out += c;
+            }
+        }
+        return false;
+    }
+
+    static bool parse_scalar(const string& line, size_t& pos, value& val) {
+        string item;
+        if ((pos < line.size()) && (line[pos] == '"')) {
+            if (!parse_string(line, pos, item)) {
+                return false;
+            }
+            val.items.push_back(item);
+            val.is_string.push_back(1);
+            return true;
+        }
+        size_t end = line.find_first_of(",]} \t\r\n", pos);
+        if (end == string::npos) {
+            end = line.size();
+        }
+        item = line.substr(pos, end - pos);
+        if ((item.size() == 0) ||
+            (item.find_first_not_of("0123456789+-.eEtrufalsn") !=
+             string::npos)) {
+            return false;
+        }
+        pos = end;
+        val.items.push_back(item);
+        val.is_string.push_back(0);
+        return true;
+    }
+};
+
+/*
+ * builds the JSON object of a response
+ */
+class json_response {
+  public:
+    json_response& add(const string& key, const string& text) {
+        add_key(key);
+        m_buf << quote(text);
+        return *this;
+    }
+
+    json_response& add(const string& key, const char* text) {
+        return add(key, string(text));
+    }
+
+    json_response& add(const string& key, double number) {
+        add_key(key);
+        m_buf << format(number);
+        return *this;
+    }
+
+    json_response& add(const string& key, bool flag) {
+        add_key(key);
+        m_buf << (flag ? "true" : "false");
+        return *this;
+    }
+
+    json_response& add(const string& key, size_t number) {
+        add_key(key);
+        m_buf << number;
+        return *this;
+    }
+
+    json_response& add(const string& key, unsigned int number) {
+        return add(key, (size_t)number);
+    }
+
+    /*
+     * value that already is JSON (arrays, objects and echoed ids)
+     */
+    json_response& add_raw(const string& key, const string& json) {
+        add_key(key);
+        m_buf << json;
+        return *this;
+    }
+
+    string str() const {
+        return m_buf.str() + "}";
+    }
+
+    static string quote(const string& text) {
+        string out = "\"";
+        for (char c : text) {
+            switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char esc[8];
+                    snprintf(esc, sizeof(esc), "\\u%04x", c);
+                    out += esc;
+                } else {
+                    out += c;
+                }
+            }
+        }
+        return out + "\"";
+    }
+
+    static string format(double number) {
+        if (!isfinite(number)) {
+            return "null";
+        }
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.15e", number);
+        return buf;
+    }
+
+  private:
+    stringstream m_buf;
+    bool m_empty = true;
+
+    void add_key(const string& key) {
+        m_buf << (m_empty ? "{" : ", ") << quote(key) << ": ";
+        m_empty = false;
+    }
+};
+
+/*
+ * make stdout usable for the responses: everything else printed to stdout
+ * (e.g. by the calculators) goes to stderr instead. returns the file
+ * descriptor of the original stdout.
+ */
+inline int redirect_stdout_to_stderr() {
+    cout.flush();
+    fflush(stdout);
+    int response_fd = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    return response_fd;
+}
+
+class PoF_server {
+  public:
+    /*
+     * the defaults of the requests and the settings of the recursion
+     */
+    PoF_server(double p, unsigned int dm, unsigned int max_d,
+               unsigned int num_threads, bool use_cache,
+               unsigned int exhaustive_max_cols)
+        : m_p(p), m_dm(dm), m_max_d(max_d), m_num_threads(num_threads),
+          m_use_cache(use_cache), m_exhaustive_max_cols(exhaustive_max_cols) {
+    }
+
+    /*
+     * load a calculator in the same way as the command line (rxn names,
+     * uncompressed or compressed network). the files are checked first: the
+     * calculators exit (or crash) if they can't read them. count overflows
+     * of the recursion are reported instead of stopping the program (see
+     * add_family).
+     */
+    static bool load_calculator(const string& mcs_fname,
+                                const string& compr_fname,
+                                const string& names_fname, size_t r,
+                                bool normalize, PoF_calculator& calc,
+                                string& error) {
+        for (const string& fname : {mcs_fname, compr_fname, names_fname}) {
+            if ((fname.size() > 0) && !ifstream(fname).good()) {
+                error = "can't open " + fname;
+                return false;
+            }
+        }
+        if (mcs_fname.size() == 0) {
+            error = "no MCS file given";
+            return false;
+        }
+        if ((names_fname.size() > 0) && (compr_fname.size() > 0)) {
+            error = "the numbers of compressed rxns are derived from the "
+                    "names --> \"compr\" can't be combined with \"names\"";
+            return false;
+        }
+        if (!check_input_files(mcs_fname, compr_fname, names_fname, r,
+                               error)) {
+            return false;
+        }
+        if (names_fname.size() > 0) {
+            calc = PoF_calculator(
+                mcs_fname, PoF_calculator::read_rxn_name_file(names_fname), r,
+                normalize);
+        } else if (compr_fname.size() == 0) {
+            calc = PoF_calculator(mcs_fname, normalize);
+        } else {
+            calc = PoF_calculator(mcs_fname, compr_fname, r, normalize);
+        }
+        return true;
+    }
+
+    void add_family(const string& name, PoF_calculator calc) {
+        family& fam = m_families[name];
+        fam.calc = move(calc);
+        fam.calc.set_exit_on_overflow(false);
+        fam.oracle.reset();
+        fam.results.clear();
+    }
+
+    /*
+     * answer the requests in in (one per line) until EOF or a shutdown
+     * request. the responses are written to the file descriptor out.
+     * returns false after a shutdown request.
+     */
+    bool serve(int in, int out) {
+        string pending;
+        char buf[1 << 16];
+        while (true) {
+            size_t newline;
+            while ((newline = pending.find('\n')) != string::npos) {
+                string line = pending.substr(0, newline);
+                pending.erase(0, newline + 1);
+                if (line.find_first_not_of(" \t\r") == string::npos) {
+                    continue;
+                }
+                bool shutdown = false;
+                string response = handle(line, shutdown) + "\n";
+                if (!write_all(out, response)) {
+                    return true;
+                }
+                if (shutdown) {
+                    return false;
+                }
+            }
+            ssize_t num_read = read(in, buf, sizeof(buf));
+            if (num_read < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return true;
+            }
+            if (num_read == 0) {
+                // EOF --> the last line might lack its newline
+                if (pending.find_first_not_of(" \t\r") != string::npos) {
+                    bool shutdown = false;
+                    write_all(out, handle(pending, shutdown) + "\n");
+                    return !shutdown;
+                }
+                return true;
+            }
+            pending.append(buf, num_read);
+        }
+    }
+
+    /*
+     * listen on a Unix socket and serve one connection after the other until
+     * a shutdown request
+     */
+    void serve_socket(const string& path) {
+        int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if ((server_fd < 0) || (path.size() >= sizeof(addr.sun_path))) {
+            cout << "Error creating socket " << path << endl;
+            exit(EXIT_FAILURE);
+        }
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        // only replace a socket (e.g. left behind by a killed server)
+        struct stat info;
+        if (lstat(path.c_str(), &info) == 0) {
+            if (!S_ISSOCK(info.st_mode)) {
+                cout << "Error: " << path << " exists and is not a socket"
+                     << endl;
+                exit(EXIT_FAILURE);
+            }
+            unlink(path.c_str());
+        }
+        if ((bind(server_fd, (sockaddr*)&addr, sizeof(addr)) < 0) ||
+            (listen(server_fd, 16) < 0)) {
+            cout << "Error binding socket " << path << ": " << strerror(errno)
+                 << endl;
+            exit(EXIT_FAILURE);
+        }
+        cout << "Listening on " << path << "\n" << endl;
+        bool running = true;
+        while (running) {
+            int client_fd = accept(server_fd, NULL, NULL);
+            if (client_fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                cout << "Error accepting connection: " << strerror(errno)
+                     << endl;
+                break;
+            }
+            running = serve(client_fd, client_fd);
+            close(client_fd);
+        }
+        close(server_fd);
+        unlink(path.c_str());
+    }
+
+    /*
+     * answer one request
+     */
+    string handle(const string& line, bool& shutdown) {
+        json_request request;
+        json_response response;
+        string error;
+        if (!request.parse(line, error)) {
+            return response.add("ok", false).add("error", error).str();
+        }
+        if (request.has("id")) {
+            const json_request::value& id = request.values["id"];
+            bool quoted = (id.is_string.size() == 1) && id.is_string[0];
+            response.add_raw("id", (quoted)
+                                       ? json_response::quote(id.items[0])
+                                       : request.get_string("id", "null"));
+        }
+        string cmd = request.get_string("cmd");
+        auto start = chrono::steady_clock::now();
+        bool ok;
+        if (cmd == "info") {
+            ok = handle_info(response);
+        } else if (cmd == "load") {
+            ok = handle_load(request, response, error);
+        } else if (cmd == "unload") {
+            ok = (m_families.erase(request.get_string("family", "default")) >
+                  0);
+            if (!ok) {
+                error = "unknown family";
+            }
+        } else if (cmd == "pof") {
+            ok = handle_pof(request, response, error);
+        } else if (cmd == "lethal") {
+            ok = handle_lethal(request, response, error);
+        } else if (cmd == "scenario") {
+            ok = handle_scenario(request, response, error);
+        } else if (cmd == "shutdown") {
+            shutdown = true;
+            ok = true;
+        } else {
+            ok = false;
+            error = "unknown cmd '" + cmd + "'";
+        }
+        if (!ok) {
+            return response.add("ok", false).add("error", error).str();
+        }
+        double seconds = chrono::duration<double>(
+                             chrono::steady_clock::now() - start)
+                             .count();
+        return response.add("ok", true).add("seconds", seconds).str();
+    }
+
+  private:
+    struct family {
+        // reduced calculator (its MCSs stay untouched by the requests)
+        PoF_calculator calc;
+        // oracle over the MCSs (built with the first lethality or scenario
+        // request)
+        unique_ptr<Lethality_oracle> oracle;
+        // result table and (corrected) d0 of the recursion per requested d0
+        map<unsigned int, pair<Matrix<wide_count>, unsigned int>> results;
+    };
+    map<string, family> m_families;
+    double m_p;
+    unsigned int m_dm, m_max_d, m_num_threads;
+    bool m_use_cache;
+    unsigned int m_exhaustive_max_cols;
+
+    static bool write_all(int fd, const string& text) {
+        size_t written = 0;
+        while (written < text.size()) {
+            ssize_t n = send(fd, text.data() + written, text.size() - written,
+                             MSG_NOSIGNAL);
+            if ((n < 0) && (errno == ENOTSOCK)) {
+                n = write(fd, text.data() + written, text.size() - written);
+            }
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            written += n;
+        }
+        return true;
+    }
+
+    family* get_family(const json_request& request, string& error) {
+        string name = request.get_string("family", "default");
+        auto search = m_families.find(name);
+        if (search == m_families.end()) {
+            error = "unknown family '" + name + "'";
+            return nullptr;
+        }
+        return &search->second;
+    }
+
+    Lethality_oracle& get_oracle(family& fam) {
+        const PoF_calculator& calc = fam.calc;
+        if (!fam.oracle) {
+            fam.oracle.reset(new Lethality_oracle(
+                calc.m_MCSs, calc.m_r_reduced, calc.m_mcs1_rxns,
+                calc.m_column_rxn_counts, calc.m_r, calc.m_column_names));
+        }
+        return *fam.oracle;
+    }
+
+    /*
+     * check the files of a load request for what the calculators can't
+     * handle: no MCSs, binary MCSs that aren't binary strings of the same
+     * length, unknown rxn names and numbers of compressed rxns that aren't a
+     * positive number per column (read like read_comp_rxn_file). r has to
+     * cover the rxns of the columns. returns false (and sets error) for the
+     * first problem.
+     */
+    static bool check_input_files(const string& mcs_fname,
+                                  const string& compr_fname,
+                                  const string& names_fname, size_t r,
+                                  string& error) {
+        // number of columns and of uncompressed rxns
+        size_t num_cols = 0, num_rxns = 0, num_MCSs = 0, line_num = 0;
+        ifstream file(mcs_fname);
+        string line;
+        if (names_fname.size() > 0) {
+            vector<string> names =
+                PoF_calculator::read_rxn_name_file(names_fname);
+            set<string> known(names.begin(), names.end());
+            for (const string& name : names) {
+                num_rxns += count(name.begin(), name.end(), '%') + 1;
+            }
+            num_cols = names.size();
+            while (getline(file, line)) {
+                line_num++;
+                size_t pos = 0, card = 0;
+                while (pos < line.size()) {
+                    size_t end = line.find_first_of(" ,\t\r", pos);
+                    if (end == string::npos) {
+                        end = line.size();
+                    }
+                    if (end > pos) {
+                        string name = line.substr(pos, end - pos);
+                        if (!known.count(name)) {
+                            error = "unknown reaction name '" + name +
+                                    "' in line " + to_string(line_num) +
+                                    " of " + mcs_fname;
+                            return false;
+                        }
+                        card++;
+                    }
+                    pos = end + 1;
+                }
+                num_MCSs += (card > 0);
+            }
+        } else {
+            while (getline(file, line)) {
+                line_num++;
+                if ((line.find_first_not_of("01") != string::npos) ||
+                    (line.find('1') == string::npos)) {
+                    error = "line " + to_string(line_num) + " of " +
+                            mcs_fname + " is no binary MCS";
+                    return false;
+                }
+                if ((num_MCSs > 0) && (line.size() != num_cols)) {
+                    error = "lines in " + mcs_fname + " differ in length";
+                    return false;
+                }
+                num_cols = line.size();
+                num_MCSs++;
+            }
+            num_rxns = num_cols;
+        }
+        if (num_MCSs == 0) {
+            error = "no MCSs in " + mcs_fname;
+            return false;
+        }
+        if (compr_fname.size() > 0) {
+            ifstream compr_file(compr_fname);
+            getline(compr_file, line);
+            istringstream iss(line);
+            string count;
+            size_t num_counts = 0;
+            num_rxns = 0;
+            while (getline(iss, count, ' ')) {
+                char* end;
+                long value = strtol(count.c_str(), &end, 10);
+                if ((end == count.c_str()) || (value <= 0) ||
+                    (string(end).find_first_not_of("\r") != string::npos)) {
+                    error = "invalid number of compressed rxns '" + count +
+                            "' in " + compr_fname;
+                    return false;
+                }
+                num_counts++;
+                num_rxns += value;
+            }
+            if (num_counts != num_cols) {
+                error = "expected " + to_string(num_cols) +
+                        " numbers of compressed rxns (one per column) in " +
+                        compr_fname + " but found " + to_string(num_counts);
+                return false;
+            }
+        }
+        if ((r > 0) && (r < num_rxns)) {
+            error = "r is smaller than the number of rxns in the columns (" +
+                    to_string(num_rxns) + ")";
+            return false;
+        }
+        return true;
+    }
+
+    /*
+     * p, dm and d0 of a request (defaulting to the command line). returns
+     * false (and sets error) for invalid values.
+     */
+    bool get_PoF_parameters(const json_request& request, double& p,
+                            unsigned int& dm, unsigned int& max_d,
+                            string& error) const {
+        if (!request.get_number("p", m_p, p, error) ||
+            !request.get_count("dm", m_dm, dm, error) ||
+            !request.get_count("d0", m_max_d, max_d, error)) {
+            return false;
+        }
+        if ((p <= 0) || (p >= 1)) {
+            error = "p should be between 0 and 1";
+            return false;
+        }
+        return true;
+    }
+
+    bool handle_info(json_response& response) const {
+        string families = "[";
+        for (const auto& elem : m_families) {
+            const PoF_calculator& calc = elem.second.calc;
+            json_response fam;
+            string cached = "[";
+            for (const auto& result : elem.second.results) {
+                cached += ((cached.size() > 1) ? ", " : "") +
+                          to_string(result.first);
+            }
+            fam.add("family", elem.first)
+                .add("columns", calc.m_r_reduced + calc.m_mcs1_rxns.size())
+                .add("rxns", calc.m_r)
+                .add("mcs", calc.m_MCSs.size() + calc.m_mcs1_rxns.size())
+                .add_raw("cached_d0", cached + "]");
+            families += ((families.size() > 1) ? ", " : "") + fam.str();
+        }
+        response.add_raw("families", families + "]");
+        return true;
+    }
+
+    bool handle_load(const json_request& request, json_response& response,
+                     string& error) {
+        string name = request.get_string("family", "default");
+        size_t r;
+        if (!request.get_count("r", (size_t)0, r, error)) {
+            return false;
+        }
+        PoF_calculator calc;
+        if (!load_calculator(request.get_string("mcs"),
+                             request.get_string("compr"),
+                             request.get_string("names"), r,
+                             request.get_bool("normalize"), calc, error)) {
+            return false;
+        }
+        response.add("family", name)
+            .add("columns", calc.m_r_reduced + calc.m_mcs1_rxns.size())
+            .add("rxns", calc.m_r);
+        add_family(name, move(calc));
+        return true;
+    }
+
+    /*
+     * lower and upper bound and polynomial PoF for p and dm from the result
+     * table for d0 (running the recursion if it isn't cached)
+     */
+    bool handle_pof(const json_request& request, json_response& response,
+                    string& error) {
+        family* fam = get_family(request, error);
+        if (!fam) {
+            return false;
+        }
+        double p;
+        unsigned int dm, max_d;
+        if (!get_PoF_parameters(request, p, dm, max_d, error)) {
+            return false;
+        }
+        PoF_calculator& calc = fam->calc;
+        auto search = fam->results.find(max_d);
+        bool cached = (search != fam->results.end());
+        if (!cached) {
+            calc.get_cardinalities(max_d, m_num_threads, m_use_cache, false,
+                                   false, m_exhaustive_max_cols);
+            if (calc.m_count_overflow) {
+                error = "count overflow (reduce d0)";
+                return false;
+            }
+            search = fam->results
+                         .insert(make_pair(max_d, make_pair(calc.m_cd_table,
+                                                            calc.m_max_d)))
+                         .first;
+        }
+        calc.m_cd_table.swap(search->second.first);
+        calc.m_max_d = search->second.second;
+        double lower, upper, polynomial;
+        tie(lower, upper) = calc.get_PoF_bounds(p, dm);
+        polynomial = get<0>(calc.get_final_PoF(
+            calc.convert_table(calc.m_cd_table), p, false));
+        calc.m_cd_table.swap(search->second.first);
+        response.add("lower", lower)
+            .add("upper", upper)
+            .add("polynomial", polynomial)
+            .add("d0", search->second.second)
+            .add("cached", cached);
+        return true;
+    }
+
+    bool handle_lethal(const json_request& request, json_response& response,
+                       string& error) {
+        family* fam = get_family(request, error);
+        if (!fam) {
+            return false;
+        }
+        vector<string> sets = request.get_array("sets");
+        if (request.has("set")) {
+            sets = request.get_array("set");
+        }
+        const Lethality_oracle& oracle = get_oracle(*fam);
+        vector<int> results(sets.size());
+#pragma omp parallel num_threads(m_num_threads)
+        {
+            vector<rxn_idx> cols;
+            MCS_index::query_buffer buf;
+#pragma omp for schedule(dynamic, 256)
+            for (size_t i = 0; i < sets.size(); i++) {
+                results[i] = oracle.is_lethal(sets[i], cols, buf);
+            }
+        }
+        string lethal = "[";
+        for (size_t i = 0; i < results.size(); i++) {
+            lethal += (i > 0) ? ", " : "";
+            lethal += (results[i] < 0) ? "null" : to_string(results[i]);
+        }
+        response.add_raw("lethal", lethal + "]");
+        return true;
+    }
+
+    /*
+     * conditional PoF of mutant backgrounds (as run_scenarios, in parallel
+     * with one thread per background). invalid backgrounds get null bounds.
+     */
+    bool handle_scenario(const json_request& request, json_response& response,
+                         string& error) {
+        family* fam = get_family(request, error);
+        if (!fam) {
+            return false;
+        }
+        vector<string> backgrounds = request.get_array("backgrounds");
+        if (request.has("background")) {
+            backgrounds = request.get_array("background");
+        }
+        double p;
+        unsigned int dm, max_d;
+        if (!get_PoF_parameters(request, p, dm, max_d, error)) {
+            return false;
+        }
+        const PoF_calculator& calc = fam->calc;
+        const Lethality_oracle& oracle = get_oracle(*fam);
+        vector<tuple<double, double>> bounds(backgrounds.size());
+        bool overflow = false;
+#pragma omp parallel num_threads(m_num_threads)
+        {
+            vector<rxn_idx> background;
+#pragma omp for schedule(dynamic, 1)
+            for (size_t i = 0; i < backgrounds.size(); i++) {
+                int status = oracle.parse(backgrounds[i], background);
+                PoF_calculator scen;
+                if (status < 0) {
+                    bounds[i] = make_tuple(NAN, NAN);
+                } else if ((status > 0) ||
+                           !calc.get_scenario_calculator(
+                               background, oracle.get_index(), scen)) {
+                    bounds[i] = make_tuple(1.0, 1.0);
+                } else {
+                    scen.get_scenario_cardinalities(max_d, m_use_cache,
+                                                    m_exhaustive_max_cols);
+                    if (scen.m_count_overflow) {
+#pragma omp atomic write
+                        overflow = true;
+                    }
+                    unsigned int scen_dm =
+                        (dm > background.size()) ? dm - background.size() : 0;
+                    bounds[i] = scen.get_PoF_bounds(p, scen_dm);
+                }
+            }
+        }
+        if (overflow) {
+            error = "count overflow (reduce d0)";
+            return false;
+        }
+        string lower = "[", upper = "[";
+        for (size_t i = 0; i < bounds.size(); i++) {
+            lower += ((i > 0) ? ", " : "") +
+                     json_response::format(get<0>(bounds[i]));
+            upper += ((i > 0) ? ", " : "") +
+                     json_response::format(get<1>(bounds[i]));
+        }
+        response.add_raw("lower", lower + "]").add_raw("upper", upper + "]");
+        return true;
+    }
+};
+
+#endif /* SERVER_HPP */
@@ -0,0 +1,585 @@
+#ifndef SET_KERNELS_HPP
+#define SET_KERNELS_HPP
+
+#include "cpu_features.hpp"
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#ifdef CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+using namespace std;
+
+/*
+ * kernels for sorted arrays of (unique) rxn indices as used in the sparse
+ * Cutset representation: intersection test, difference, size of the
+ * difference and union. on x86, blocks of 4 (SSE4.2), 8 (AVX2) or 16
+ * (AVX-512) elements of both arrays are compared all-against-all (by comparing
+ * one block with all rotations of the other) and the non-matching elements
+ * are compacted with a shuffle (or a compress-store). if one array is much
+ * smaller than the other, the small one is looked up in the large one by
+ * galloping (exponential search) instead. additionally, there is a kernel
+ * extracting the deletions from the binary strings of the MCS file. the
+ * variant of the kernels is chosen at runtime according to get_simd_level().
+ */
+
+typedef unsigned int set_elem;
+
+// use galloping if one array is at least this many times larger
+const size_t GALLOP_RATIO = 16;
+
+// below this size (of the smaller array), a single SIMD block does not fit and
+// the scalar code is called directly
+const size_t MIN_SIMD_SIZE = 4;
+
+/*
+ * position of the first element >= x in [first, last), found by exponential
+ * search from first
+ */
+inline const set_elem* gallop(const set_elem* first, const set_elem* last,
+                              set_elem x) {
+    size_t step = 1;
+    const set_elem* lo = first;
+    while ((first + step < last) && (first[step] < x)) {
+        lo = first + step;
+        step *= 2;
+    }
+    return lower_bound(lo, min(first + step + 1, last), x);
+}
+
+/*
+ * scalar kernels (also used for the tails of the SIMD kernels)
+ */
+inline bool intersect_scalar(const set_elem* a, size_t na, const set_elem* b,
+                             size_t nb) {
+    const set_elem *last_a = a + na, *last_b = b + nb;
+    while ((a != last_a) && (b != last_b)) {
+        if (*a < *b) {
+            a++;
+        } else if (*b < *a) {
+            b++;
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * elements of a that are not in b. returns their number and writes them to
+ * out if it is not NULL. last is set to the last element of the difference.
+ */
+inline size_t difference_scalar(const set_elem* a, size_t na,
+                                const set_elem* b, size_t nb, set_elem* out,
+                                set_elem* last) {
+    const set_elem *last_a = a + na, *last_b = b + nb;
+    size_t count = 0;
+    for (; a != last_a; a++) {
+        while ((b != last_b) && (*b < *a)) {
+            b++;
+        }
+        if ((b == last_b) || (*b != *a)) {
+            if (out) {
+                out[count] = *a;
+            }
+            *last = *a;
+            count++;
+        }
+    }
+    return count;
+}
+
+/*
+ * galloping versions for a much smaller than b or vice versa
+ */
+inline bool intersect_gallop(const set_elem* a, size_t na, const set_elem* b,
+                             size_t nb) {
+    if (na > nb) {
+        swap(a, b);
+        swap(na, nb);
+    }
+    const set_elem* last_b = b + nb;
+    for (size_t i = 0; (i < na) && (b != last_b); i++) {
+        b = gallop(b, last_b, a[i]);
+        if ((b != last_b) && (*b == a[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline size_t difference_gallop(const set_elem* a, size_t na,
+                                const set_elem* b, size_t nb, set_elem* out,
+                                set_elem* last) {
+    const set_elem* last_b = b + nb;
+    size_t count = 0;
+    for (size_t i = 0; i < na; i++) {
+        b = gallop(b, last_b, a[i]);
+        if ((b == last_b) || (*b != a[i])) {
+            if (out) {
+                out[count] = a[i];
+            }
+            *last = a[i];
+            count++;
+        }
+    }
+    return count;
+}
+
+/*
+ * append the positions of the '1's in a binary string of length n to out
+ */
+inline void find_ones_scalar(const char* str, size_t n, vector<set_elem>& out) {
+    for (size_t i = 0; i < n; i++) {
+        if (str[i] == '1') {
+            out.push_back(i);
+        }
+    }
+}
+
+#ifdef CPU_FEATURES_X86
+/*
+ * shuffle tables for the compaction: for every mask of lanes to keep, the
+ * (byte-wise for SSE4.2, lane-wise for AVX2) indices moving them to the front
+ */
+struct compaction_tables {
+    uint8_t sse[16][16];
+    uint32_t avx2[256][8];
+
+    compaction_tables() {
+        for (unsigned int mask = 0; mask < 16; mask++) {
+            unsigned int n = 0;
+            memset(sse[mask], 0x80, 16);
+            for (unsigned int lane = 0; lane < 4; lane++) {
+                if (mask & (1 << lane)) {
+                    for (unsigned int byte = 0; byte < 4; byte++) {
+                        sse[mask][4 * n + byte] = 4 * lane + byte;
+                    }
+                    n++;
+                }
+            }
+        }
+        for (unsigned int mask = 0; mask < 256; mask++) {
+            unsigned int n = 0;
+            for (unsigned int lane = 0; lane < 8; lane++) {
+                if (mask & (1 << lane)) {
+                    avx2[mask][n++] = lane;
+                }
+            }
+            for (; n < 8; n++) {
+                avx2[mask][n] = 0;
+            }
+        }
+    }
+};
+
+inline const compaction_tables& get_compaction_tables() {
+    static const compaction_tables tables;
+    return tables;
+}
+
+/*
+ * the SIMD kernels process blocks of W elements of both arrays. the matches
+ * of the current block of a are accumulated over all blocks of b it
+ * overlaps. the block with the smaller maximum is advanced (both if the
+ * maxima are equal). the remaining elements are handled by the scalar code
+ * while taking the matches of a partially processed block of a into account.
+ */
+
+/*
+ * lanes of va that are equal to any lane of vb (4 lanes)
+ */
+__attribute__((target("sse4.2,popcnt"))) inline unsigned int
+match_mask_sse(__m128i va, __m128i vb) {
+    __m128i m = _mm_cmpeq_epi32(va, vb);
+    m = _mm_or_si128(m, _mm_cmpeq_epi32(
+                            va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+    m = _mm_or_si128(m, _mm_cmpeq_epi32(
+                            va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+    m = _mm_or_si128(m, _mm_cmpeq_epi32(
+                            va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+    return _mm_movemask_ps(_mm_castsi128_ps(m));
+}
+
+/*
+ * lanes of va that are equal to any lane of vb (8 lanes)
+ */
+__attribute__((target("avx2"))) inline unsigned int
+match_mask_avx2(__m256i va, __m256i vb) {
+    __m256i m = _mm256_cmpeq_epi32(va, vb);
+    for (int r = 1; r < 8; r++) {
+        __m256i rot = _mm256_setr_epi32(r, r + 1, r + 2, r + 3, r + 4, r + 5,
+                                        r + 6, r + 7);
+        rot = _mm256_and_si256(rot, _mm256_set1_epi32(7));
+        m = _mm256_or_si256(
+            m, _mm256_cmpeq_epi32(va, _mm256_permutevar8x32_epi32(vb, rot)));
+    }
+    return _mm256_movemask_ps(_mm256_castsi256_ps(m));
+}
+
+/*
+ * scalar tail of the difference. the first W elements of a belong to a
+ * block whose matches with the preceding elements of b are in matched.
+ */
+inline size_t difference_tail(const set_elem* a, size_t na, const set_elem* b,
+                              size_t nb, unsigned int W, unsigned int matched,
+                              set_elem* out, set_elem* last) {
+    size_t count = 0;
+    const set_elem* last_b = b + nb;
+    for (size_t i = 0; i < na; i++) {
+        if ((i < W) && (matched & (1u << i))) {
+            continue;
+        }
+        while ((b != last_b) && (*b < a[i])) {
+            b++;
+        }
+        if ((b == last_b) || (*b != a[i])) {
+            if (out) {
+                out[count] = a[i];
+            }
+            *last = a[i];
+            count++;
+        }
+    }
+    return count;
+}
+
+__attribute__((target("sse4.2,popcnt"))) inline bool
+intersect_sse(const set_elem* a, size_t na, const set_elem* b, size_t nb) {
+    size_t i = 0, j = 0;
+    while ((i + 4 <= na) && (j + 4 <= nb)) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+        if (match_mask_sse(va, vb)) {
+            return true;
+        }
+        set_elem max_a = a[i + 3], max_b = b[j + 3];
+        i += (max_a <= max_b) ? 4 : 0;
+        j += (max_b <= max_a) ? 4 : 0;
+    }
+    return intersect_scalar(a + i, na - i, b + j, nb - j);
+}
+
+__attribute__((target("sse4.2,popcnt"))) inline size_t
+difference_sse(const set_elem* a, size_t na, const set_elem* b, size_t nb,
+               set_elem* out, set_elem* last) {
+    const compaction_tables& tables = get_compaction_tables();
+    size_t i = 0, j = 0, count = 0;
+    unsigned int matched = 0;
+    while ((i + 4 <= na) && (j + 4 <= nb)) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+        matched |= match_mask_sse(va, vb);
+        set_elem max_a = a[i + 3], max_b = b[j + 3];
+        if (max_a <= max_b) {
+            unsigned int keep = ~matched & 0xF;
+            if (keep) {
+                if (out) {
+                    set_elem buf[4];
+                    _mm_storeu_si128(
+                        (__m128i*)buf,
+                        _mm_shuffle_epi8(va, _mm_loadu_si128((const __m128i*)
+                                                                 tables.sse[keep])));
+                    memcpy(out + count, buf,
+                           __builtin_popcount(keep) * sizeof(set_elem));
+                }
+                *last = a[i + 31 - __builtin_clz(keep)];
+                count += __builtin_popcount(keep);
+            }
+            i += 4;
+            matched = 0;
+        }
+        if (max_b <= max_a) {
+            j += 4;
+        }
+    }
+    return count + difference_tail(a + i, na - i, b + j, nb - j, 4, matched,
+                                   (out) ? out + count : NULL, last);
+}
+
+__attribute__((target("avx2,popcnt"))) inline bool
+intersect_avx2(const set_elem* a, size_t na, const set_elem* b, size_t nb) {
+    size_t i = 0, j = 0;
+    while ((i + 8 <= na) && (j + 8 <= nb)) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+        if (match_mask_avx2(va, vb)) {
+            return true;
+        }
+        set_elem max_a = a[i + 7], max_b = b[j + 7];
+        i += (max_a <= max_b) ? 8 : 0;
+        j += (max_b <= max_a) ? 8 : 0;
+    }
+    return intersect_sse(a + i, na - i, b + j, nb - j);
+}
+
+__attribute__((target("avx2,popcnt"))) inline size_t
+difference_avx2(const set_elem* a, size_t na, const set_elem* b, size_t nb,
+                set_elem* out, set_elem* last) {
+    const compaction_tables& tables = get_compaction_tables();
+    size_t i = 0, j = 0, count = 0;
+    unsigned int matched = 0;
+    while ((i + 8 <= na) && (j + 8 <= nb)) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+        matched |= match_mask_avx2(va, vb);
+        set_elem max_a = a[i + 7], max_b = b[j + 7];
+        if (max_a <= max_b) {
+            unsigned int keep = ~matched & 0xFF;
+            if (keep) {
+                if (out) {
+                    set_elem buf[8];
+                    _mm256_storeu_si256(
+                        (__m256i*)buf,
+                        _mm256_permutevar8x32_epi32(
+                            va, _mm256_loadu_si256(
+                                    (const __m256i*)tables.avx2[keep])));
+                    memcpy(out + count, buf,
+                           __builtin_popcount(keep) * sizeof(set_elem));
+                }
+                *last = a[i + 31 - __builtin_clz(keep)];
+                count += __builtin_popcount(keep);
+            }
+            i += 8;
+            matched = 0;
+        }
+        if (max_b <= max_a) {
+            j += 8;
+        }
+    }
+    return count + difference_tail(a + i, na - i, b + j, nb - j, 8, matched,
+                                   (out) ? out + count : NULL, last);
+}
+
+/*
+ * lanes of va that are equal to any lane of vb (16 lanes)
+ */
+__attribute__((target("avx512f"))) inline unsigned int
+match_mask_avx512(__m512i va, __m512i vb) {
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+                                            11, 12, 13, 14, 15);
+    __mmask16 m = _mm512_cmpeq_epi32_mask(va, vb);
+    for (int r = 1; r < 16; r++) {
+        __m512i rot = _mm512_and_si512(
+            _mm512_add_epi32(lanes, _mm512_set1_epi32(r)),
+            _mm512_set1_epi32(15));
+        // (masked form with all lanes set, as the unmasked one trips
+        // -Wmaybe-uninitialized in the GCC headers)
+        m |= _mm512_cmpeq_epi32_mask(
+            va, _mm512_mask_permutexvar_epi32(vb, 0xFFFF, rot, vb));
+    }
+    return m;
+}
+
+__attribute__((target("avx512f,avx2,popcnt"))) inline bool
+intersect_avx512(const set_elem* a, size_t na, const set_elem* b, size_t nb) {
+    size_t i = 0, j = 0;
+    while ((i + 16 <= na) && (j + 16 <= nb)) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        __m512i vb = _mm512_loadu_si512(b + j);
+        if (match_mask_avx512(va, vb)) {
+            return true;
+        }
+        set_elem max_a = a[i + 15], max_b = b[j + 15];
+        i += (max_a <= max_b) ? 16 : 0;
+        j += (max_b <= max_a) ? 16 : 0;
+    }
+    return intersect_avx2(a + i, na - i, b + j, nb - j);
+}
+
+__attribute__((target("avx512f,popcnt"))) inline size_t
+difference_avx512(const set_elem* a, size_t na, const set_elem* b, size_t nb,
+                  set_elem* out, set_elem* last) {
+    size_t i = 0, j = 0, count = 0;
+    unsigned int matched = 0;
+    while ((i + 16 <= na) && (j + 16 <= nb)) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        __m512i vb = _mm512_loadu_si512(b + j);
+        matched |= match_mask_avx512(va, vb);
+        set_elem max_a = a[i + 15], max_b = b[j + 15];
+        if (max_a <= max_b) {
+            unsigned int keep = ~matched & 0xFFFF;
+            if (keep) {
+                if (out) {
+                    // only writes the kept lanes
+                    _mm512_mask_compressstoreu_epi32(out + count, keep, va);
+                }
+                *last = a[i + 31 - __builtin_clz(keep)];
+                count += __builtin_popcount(keep);
+            }
+            i += 16;
+            matched = 0;
+        }
+        if (max_b <= max_a) {
+            j += 16;
+        }
+    }
+    return count + difference_tail(a + i, na - i, b + j, nb - j, 16, matched,
+                                   (out) ? out + count : NULL, last);
+}
+
+/*
+ * find_ones_scalar for 16 (SSE4.2), 32 (AVX2) or 64 (AVX-512) characters at
+ * once
+ */
+__attribute__((target("sse4.2,popcnt"))) inline void
+find_ones_sse(const char* str, size_t n, vector<set_elem>& out) {
+    const __m128i ones = _mm_set1_epi8('1');
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i chars = _mm_loadu_si128((const __m128i*)(str + i));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chars, ones));
+        for (; mask; mask &= mask - 1) {
+            out.push_back(i + __builtin_ctz(mask));
+        }
+    }
+    for (; i < n; i++) {
+        if (str[i] == '1') {
+            out.push_back(i);
+        }
+    }
+}
+
+__attribute__((target("avx2,popcnt"))) inline void
+find_ones_avx2(const char* str, size_t n, vector<set_elem>& out) {
+    const __m256i ones = _mm256_set1_epi8('1');
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i chars = _mm256_loadu_si256((const __m256i*)(str + i));
+        unsigned int mask =
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, ones));
+        for (; mask; mask &= mask - 1) {
+            out.push_back(i + __builtin_ctz(mask));
+        }
+    }
+    for (; i < n; i++) {
+        if (str[i] == '1') {
+            out.push_back(i);
+        }
+    }
+}
+
+__attribute__((target("avx512f,avx512bw,avx2,popcnt"))) inline void
+find_ones_avx512(const char* str, size_t n, vector<set_elem>& out) {
+    const __m512i ones = _mm512_set1_epi8('1');
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i chars = _mm512_loadu_si512(str + i);
+        uint64_t mask = _mm512_cmpeq_epi8_mask(chars, ones);
+        for (; mask; mask &= mask - 1) {
+            out.push_back(i + __builtin_ctzll(mask));
+        }
+    }
+    for (; i < n; i++) {
+        if (str[i] == '1') {
+            out.push_back(i);
+        }
+    }
+}
+#endif /* CPU_FEATURES_X86 */
+
+/*
+ * variants of the kernels for one instruction set
+ */
+struct set_kernels {
+    bool (*intersect)(const set_elem*, size_t, const set_elem*, size_t);
+    size_t (*difference)(const set_elem*, size_t, const set_elem*, size_t,
+                         set_elem*, set_elem*);
+    void (*find_ones)(const char*, size_t, vector<set_elem>&);
+};
+
+/*
+ * kernels of the level selected by get_simd_level()
+ */
+inline const set_kernels& get_set_kernels() {
+    static const set_kernels kernels[] = {
+        {intersect_scalar, difference_scalar, find_ones_scalar},
+#ifdef CPU_FEATURES_X86
+        {intersect_sse, difference_sse, find_ones_sse},
+        {intersect_avx2, difference_avx2, find_ones_avx2},
+        {intersect_avx512, difference_avx512, find_ones_avx512}
+#else
+        {intersect_scalar, difference_scalar, find_ones_scalar},
+        {intersect_scalar, difference_scalar, find_ones_scalar},
+        {intersect_scalar, difference_scalar, find_ones_scalar}
+#endif
+    };
+    return kernels[get_simd_level()];
+}
+
+/*
+ * whether the sorted arrays a and b have an element in common
+ */
+inline bool sets_intersect(const set_elem* a, size_t na, const set_elem* b,
+                           size_t nb) {
+    if ((na == 0) || (nb == 0) || (a[na - 1] < b[0]) || (b[nb - 1] < a[0])) {
+        return false;
+    }
+    if ((na * GALLOP_RATIO < nb) || (nb * GALLOP_RATIO < na)) {
+        return intersect_gallop(a, na, b, nb);
+    }
+    if ((na < MIN_SIMD_SIZE) || (nb < MIN_SIMD_SIZE)) {
+        return intersect_scalar(a, na, b, nb);
+    }
+    return get_set_kernels().intersect(a, na, b, nb);
+}
+
+/*
+ * elements of the sorted array a that are not in the sorted array b. writes
+ * them to out (if not NULL; requires space for na elements) and returns
+ * their number. last is set to the last element of the difference (if any).
+ */
+inline size_t set_difference_into(const set_elem* a, size_t na,
+                                  const set_elem* b, size_t nb, set_elem* out,
+                                  set_elem* last) {
+    if ((nb == 0) || (na == 0) || (a[na - 1] < b[0]) || (b[nb - 1] < a[0])) {
+        if (out) {
+            copy(a, a + na, out);
+        }
+        if (na > 0) {
+            *last = a[na - 1];
+        }
+        return na;
+    }
+    if (na * GALLOP_RATIO < nb) {
+        return difference_gallop(a, na, b, nb, out, last);
+    }
+    if ((na < MIN_SIMD_SIZE) || (nb < MIN_SIMD_SIZE)) {
+        return difference_scalar(a, na, b, nb, out, last);
+    }
+    return get_set_kernels().difference(a, na, b, nb, out, last);
+}
+
+/*
+ * union of the sorted arrays a and b. requires space for na + nb elements in
+ * out and returns the size of the union. the elements of b that are not in a
+ * are found with the difference kernel (and stored behind the space for a)
+ * and then merged with a. the merge never overtakes the extra elements it
+ * has not read yet.
+ */
+inline size_t set_union_into(const set_elem* a, size_t na, const set_elem* b,
+                             size_t nb, set_elem* out) {
+    set_elem last;
+    const set_elem* extra = out + na;
+    size_t n_extra = set_difference_into(b, nb, a, na, out + na, &last);
+    size_t i = 0, j = 0, k = 0;
+    while ((i < na) && (j < n_extra)) {
+        out[k++] = (a[i] < extra[j]) ? a[i++] : extra[j++];
+    }
+    while (i < na) {
+        out[k++] = a[i++];
+    }
+    return na + n_extra;
+}
+
+/*
+ * append the positions of the '1's in the binary string str to out
+ */
+inline void find_ones(const string& str, vector<set_elem>& out) {
+    get_set_kernels().find_ones(str.data(), str.size(), out);
+}
+
+#endif /* SET_KERNELS_HPP */
@@ -11,6 +11,14 @@ using namespace std;
  */
 
 template <typename T> using Matrix = vector<vector<T>>;
-typedef map<pair<size_t, size_t>, int> Counter;
+
+/**
+ * signed 128-bit integer for the entries of the result table. they are sums
+ * of millions of signed (and in the compressed case large) counts and can
+ * overflow 64 bits.
+ */
+typedef __int128 wide_count;
+
+typedef map<pair<size_t, size_t>, wide_count> Counter;
 
 #endif /* TYPES_H */
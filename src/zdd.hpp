@@ -0,0 +1,313 @@
+#ifndef ZDD_HPP
+#define ZDD_HPP
+
+#include "cutset.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+/*
+ * zero-suppressed decision diagram (ZDD) for families of cut sets. every node
+ * stands for a family of sets and has a variable (i.e. a column of the MCS
+ * matrix at a given level in the variable order), a lo child (the sets
+ * without the variable) and a hi child (the sets with the variable, which is
+ * then removed). node 0 is the empty family and node 1 the family containing
+ * only the empty set. nodes are unique (unique table) and unions are cached
+ * (operation cache). the number of lethal deletion sets (i.e. supersets of
+ * any MCS) of every cardinality is obtained by dynamic programming over the
+ * nodes, without ever listing the sets.
+ */
+class ZDD {
+  public:
+    typedef uint32_t node_id;
+    static const node_id EMPTY = 0;
+    static const node_id BASE = 1;
+
+    /*
+     * num_rxns holds the number of (uncompressed) rxns for the column at
+     * every level in the variable order
+     */
+    ZDD(const vector<unsigned int>& num_rxns) : m_num_rxns(num_rxns) {
+        // terminal nodes have the level after the last variable
+        unsigned int num_levels = num_rxns.size();
+        m_nodes.push_back(node{num_levels, EMPTY, EMPTY});
+        m_nodes.push_back(node{num_levels, BASE, BASE});
+        // number of rxns at and below every level
+        m_rxns_below.resize(num_levels + 1, 0);
+        for (size_t level = num_levels; level-- > 0;) {
+            m_rxns_below[level] = m_rxns_below[level + 1] + num_rxns[level];
+        }
+    }
+
+    /*
+     * get the node for (level, lo, hi) from the unique table or create it.
+     * nodes whose hi child is the empty family are suppressed. as only the
+     * lethal sets (i.e. the supersets of the sets in the family) matter, a
+     * family containing the empty set is replaced by {{}} (all sets are
+     * lethal) --> fewer distinct nodes when building unions.
+     */
+    node_id get_node(unsigned int level, node_id lo, node_id hi) {
+        if (hi == EMPTY || lo == BASE) {
+            return lo;
+        }
+        node_key key{level, lo, hi};
+        auto search = m_unique.find(key);
+        if (search != m_unique.end()) {
+            return search->second;
+        }
+        node_id id = m_nodes.size();
+        m_nodes.push_back(node{level, lo, hi});
+        m_unique[key] = id;
+        return id;
+    }
+
+    /*
+     * family containing the single set of the given levels (sorted)
+     */
+    node_id get_set(const vector<unsigned int>& levels) {
+        node_id id = BASE;
+        for (size_t i = levels.size(); i-- > 0;) {
+            id = get_node(levels[i], EMPTY, id);
+        }
+        return id;
+    }
+
+    /*
+     * union of two families
+     */
+    node_id unite(node_id a, node_id b) {
+        if (a == EMPTY || a == b || b == BASE) {
+            return b;
+        }
+        if (b == EMPTY || a == BASE) {
+            return a;
+        }
+        if (a > b) {
+            swap(a, b); // union is commutative --> normalize the cache key
+        }
+        uint64_t key = ((uint64_t)a << 32) | b;
+        auto search = m_union_cache.find(key);
+        if (search != m_union_cache.end()) {
+            return search->second;
+        }
+        node na = m_nodes[a], nb = m_nodes[b];
+        node_id result;
+        if (na.level < nb.level) {
+            result = get_node(na.level, unite(na.lo, b), na.hi);
+        } else if (na.level > nb.level) {
+            result = get_node(nb.level, unite(a, nb.lo), nb.hi);
+        } else {
+            result = get_node(na.level, unite(na.lo, nb.lo),
+                              unite(na.hi, nb.hi));
+        }
+        m_union_cache[key] = result;
+        return result;
+    }
+
+    /*
+     * build the family from a list of sets by balanced pairwise unions
+     */
+    node_id build_family(const vector<vector<unsigned int>>& sets) {
+        if (sets.size() == 0) {
+            return EMPTY;
+        }
+        vector<node_id> families;
+        families.reserve(sets.size());
+        for (const auto& set : sets) {
+            families.push_back(get_set(set));
+        }
+        while (families.size() > 1) {
+            vector<node_id> merged;
+            merged.reserve(families.size() / 2 + 1);
+            for (size_t i = 0; i + 1 < families.size(); i += 2) {
+                merged.push_back(unite(families[i], families[i + 1]));
+            }
+            if (families.size() % 2) {
+                merged.push_back(families.back());
+            }
+            families = merged;
+        }
+        return families[0];
+    }
+
+    /*
+     * count the lethal deletion sets (i.e. sets of uncompressed rxns whose
+     * columns contain any set in the family) for every cardinality up to
+     * max_deg. a column with n rxns counts as deleted if at least one of its
+     * rxns is deleted --> (1 + x)^n - 1 ways. for a node at level t:
+     *   L(node) = L(lo) + ((1 + x)^n_t - 1) * L(lo U hi)
+     * with the levels skipped between a node and its children contributing
+     * (1 + x)^n each (these columns don't matter for lethality). every
+     * deleted column uses up at least one of the max_deg deletions --> the
+     * family below a deleted column only needs the sets that still fit into
+     * the remaining budget, which keeps the number of unions small.
+     */
+    vector<long double> count_lethal_sets(node_id root, unsigned int max_deg) {
+        m_counts.clear();
+        m_trunc_cache.clear();
+        return count_below(truncate(root, max_deg), 0, max_deg);
+    }
+
+    /*
+     * number of nodes (including the ones created by unions)
+     */
+    size_t size() const {
+        return m_nodes.size();
+    }
+
+  private:
+    struct node {
+        unsigned int level;
+        node_id lo, hi;
+    };
+    struct node_key {
+        unsigned int level;
+        node_id lo, hi;
+        bool operator==(const node_key& other) const {
+            return level == other.level && lo == other.lo && hi == other.hi;
+        }
+    };
+    struct node_key_hash {
+        size_t operator()(const node_key& key) const {
+            uint64_t h = ((uint64_t)key.lo << 32) | key.hi;
+            h ^= (uint64_t)key.level * 0x9e3779b97f4a7c15ULL;
+            h = (h ^ (h >> 29)) * 0xbf58476d1ce4e5b9ULL;
+            return h ^ (h >> 32);
+        }
+    };
+
+    vector<node> m_nodes;
+    unordered_map<node_key, node_id, node_key_hash> m_unique;
+    unordered_map<uint64_t, node_id> m_union_cache;
+    vector<unsigned int> m_num_rxns;
+    vector<size_t> m_rxns_below;
+    // lethal set counts per node and degree budget (at the level of the
+    // node)
+    unordered_map<uint64_t, vector<long double>> m_counts;
+    unordered_map<uint64_t, node_id> m_trunc_cache;
+
+    /*
+     * remove all sets with more than max_card elements from the family
+     */
+    node_id truncate(node_id id, unsigned int max_card) {
+        if (id == EMPTY || id == BASE) {
+            return id;
+        }
+        if (max_card == 0) {
+            return EMPTY; // only BASE contains the empty set
+        }
+        uint64_t key = ((uint64_t)id << 32) | max_card;
+        auto search = m_trunc_cache.find(key);
+        if (search != m_trunc_cache.end()) {
+            return search->second;
+        }
+        const node n = m_nodes[id];
+        node_id result = get_node(n.level, truncate(n.lo, max_card),
+                                  truncate(n.hi, max_card - 1));
+        m_trunc_cache[key] = result;
+        return result;
+    }
+
+    /*
+     * multiply polynomial by (1 + x)^n (truncated at max_deg)
+     */
+    static vector<long double> times_all(vector<long double> poly, size_t n,
+                                         unsigned int max_deg) {
+        if (poly.size() == 0) {
+            return poly;
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t deg = min(poly.size(), (size_t)max_deg);
+            poly.resize(deg + 1, 0);
+            for (size_t k = deg; k > 0; k--) {
+                poly[k] += poly[k - 1];
+            }
+        }
+        return poly;
+    }
+
+    /*
+     * lethal counts (up to max_deg) for the family at node for the columns
+     * from level on
+     */
+    vector<long double> count_below(node_id id, unsigned int level,
+                                    unsigned int max_deg) {
+        if (id == EMPTY) {
+            return vector<long double>();
+        }
+        const node n = m_nodes[id];
+        return times_all(count_at_node(id, max_deg),
+                         m_rxns_below[level] - m_rxns_below[n.level], max_deg);
+    }
+
+    vector<long double> count_at_node(node_id id, unsigned int max_deg) {
+        if (id == BASE) {
+            return vector<long double>{1};
+        }
+        uint64_t key = ((uint64_t)id << 32) | max_deg;
+        auto search = m_counts.find(key);
+        if (search != m_counts.end()) {
+            return search->second;
+        }
+        const node n = m_nodes[id];
+        vector<long double> result =
+            count_below(n.lo, n.level + 1, max_deg);
+        // column deleted: (1 + x)^n - 1. the sets of the family have at
+        // least one element --> max_deg > 0 here
+        node_id below = unite(truncate(n.lo, max_deg - 1),
+                              truncate(n.hi, max_deg - 1));
+        vector<long double> with = count_below(below, n.level + 1, max_deg - 1);
+        if (with.size() > 0) {
+            vector<long double> deleted =
+                times_all(with, m_num_rxns[n.level], max_deg);
+            for (size_t k = 0; k < with.size(); k++) {
+                deleted[k] -= with[k];
+            }
+            if (deleted.size() > result.size()) {
+                result.resize(deleted.size(), 0);
+            }
+            for (size_t k = 0; k < deleted.size(); k++) {
+                result[k] += deleted[k];
+            }
+        }
+        m_counts[key] = result;
+        return result;
+    }
+};
+
+/*
+ * variable order heuristics for the columns of the MCS matrix. returns the
+ * columns in the order of their levels; columns in no MCS are left out.
+ *   "appearance": order of first appearance in the (cardinality-sorted) MCSs
+ *                 --> columns used together end up on neighbouring levels
+ *   "frequency":  most frequent columns first
+ *   "index":      original column order
+ */
+vector<rxn_idx> get_zdd_variable_order(const vector<Cutset>& MCSs,
+                                       size_t num_cols, const string& order) {
+    vector<size_t> freqs(num_cols, 0);
+    vector<rxn_idx> result;
+    vector<char> seen(num_cols, 0);
+    for (const Cutset& cs : MCSs) {
+        for (rxn_idx rxn : cs.m_active_rxns) {
+            freqs[rxn]++;
+            if (!seen[rxn]) {
+                seen[rxn] = 1;
+                result.push_back(rxn);
+            }
+        }
+    }
+    if (order == "frequency") {
+        stable_sort(result.begin(), result.end(),
+                    [&](rxn_idx a, rxn_idx b) { return freqs[a] > freqs[b]; });
+    } else if (order == "index") {
+        sort(result.begin(), result.end());
+    }
+    return result;
+}
+
+#endif /* ZDD_HPP */